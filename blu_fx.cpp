@@ -26,16 +26,29 @@
 #include "XPStandardWidgets.h"
 #include "XPWidgets.h"
 
+#include "blu_fx.h"
+#include "blu_fx_kernel.h"
+
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <math.h>
 #include <sstream>
 
-#if !IBM
+#if IBM
+#include <direct.h>
+#else
+#include <dlfcn.h>
+#include <errno.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 
 #if APL
 #include <OpenGL/gl.h>
+#include <OpenGL/glext.h>
 #elif IBM
 #include "GLee.h"
 #elif LIN
@@ -56,605 +69,2602 @@
 #define CONFIG_PATH "./Resources/plugins/" NAME_LOWERCASE "/" NAME_LOWERCASE ".ini"
 #endif
 
+// define trace file path
+#if IBM
+#define TRACE_PATH ".\\Resources\\plugins\\" NAME_LOWERCASE "\\" NAME_LOWERCASE "_trace.json"
+#else
+#define TRACE_PATH "./Resources/plugins/" NAME_LOWERCASE "/" NAME_LOWERCASE "_trace.json"
+#endif
+
+// define frame time export path
+#if IBM
+#define FRAME_TIMES_PATH ".\\Resources\\plugins\\" NAME_LOWERCASE "\\" NAME_LOWERCASE "_frame_times.csv"
+#else
+#define FRAME_TIMES_PATH "./Resources/plugins/" NAME_LOWERCASE "/" NAME_LOWERCASE "_frame_times.csv"
+#endif
+
+// define program binary cache directory path
+#if IBM
+#define PROGRAM_CACHE_PATH ".\\Resources\\plugins\\" NAME_LOWERCASE "\\cache\\"
+#else
+#define PROGRAM_CACHE_PATH "./Resources/plugins/" NAME_LOWERCASE "/cache/"
+#endif
+
+// define the tag at the start of every program binary cache file
+#define PROGRAM_CACHE_MAGIC 0x42554C42
+
+// OpenGL enums of GL_ARB_get_program_binary which are missing from some platform headers
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// OpenGL enums of GL_ARB_timer_query which are missing from some platform headers
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+// OpenGL enums of GL_ARB_vertex_array_object which are missing from some platform headers
+#ifndef GL_VERTEX_ARRAY_BINDING
+#define GL_VERTEX_ARRAY_BINDING 0x85B5
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// OpenGL entry points that are resolved at runtime, because not every platform header declares them
+typedef void (APIENTRY *GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRY *ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRY *ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRY *GetQueryObjectui64vProc)(GLuint id, GLenum pname, unsigned long long *params);
+typedef void (APIENTRY *TexStorage2DProc)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRY *BindVertexArrayProc)(GLuint array);
+
 #define DEFAULT_POST_PROCESSING_ENABLED 1
 #define DEFAULT_FPS_LIMITER_ENABLED 0
 #define DEFAULT_CONTROL_CINEMA_VERITE_ENABLED 1
 #define DEFAULT_RALEIGH_SCALE 13.0f
 #define DEFAULT_MAX_FRAME_RATE 30.0f
 #define DEFAULT_DISABLE_CINEMA_VERITE_TIME 5.0f
+#define DEFAULT_LUT_ENABLED 0
+#define DEFAULT_LUT_SIZE 33
+#define DEFAULT_TRACING_ENABLED 0
+#define DEFAULT_FRAME_STATISTICS_OVERLAY_ENABLED 0
+#define DEFAULT_QUALITY_GOVERNOR_ENABLED 0
+#define DEFAULT_PRESET_TRANSITION_TIME 1.0f
+#define DEFAULT_PRESET_TRANSITION_EASING PRESET_TRANSITION_EASING_EASE_IN_OUT
+#define DEFAULT_VIGNETTE_CENTER_X 0.5f
+#define DEFAULT_VIGNETTE_CENTER_Y 0.5f
+#define DEFAULT_VIGNETTE_RADIUS_X 1.0f
+#define DEFAULT_VIGNETTE_RADIUS_Y 1.0f
+
+// define by how much the vignette mask is smaller than the screen
+#define VIGNETTE_MASK_DOWNSCALE 4
+
+// define how many render targets the pool can hold
+#define MAX_RENDER_TARGETS 4
+
+// define how many timer queries per measured pass can be in flight
+#define GPU_TIMER_QUERY_COUNT 8
+
+// define over how many of the most recent samples the GPU time statistics are computed
+#define GPU_TIMER_SAMPLE_COUNT 256
+
+// define the number of buckets of the callback timing histograms
+#define HISTOGRAM_SUB_BUCKETS 4
+#define HISTOGRAM_BUCKET_COUNT 80
+
+// define the bounds of the time in seconds the limiter spins before a deadline instead of sleeping, the actual value adapts to the measured wake-up error
+#define MIN_SPIN_THRESHOLD 0.0002
+#define MAX_SPIN_THRESHOLD 0.02
+#define DEFAULT_SPIN_THRESHOLD 0.002
+
+// define the weight of a new sample in the exponentially weighted averages of the limiter
+#define LIMITER_SMOOTHING 0.05
+
+// define the interval in seconds at which the screen size is compared with the fake window geometry, X-Plane keeps full-screen windows sized itself so this is only a fallback
+#define FAKE_WINDOW_UPDATE_INTERVAL 1.0f
+
+// define the view type of the 3D cockpit
+#define VIEW_TYPE_3D_COCKPIT 1026
+
+// define the shares of the frame budget at which the quality governor steps down and up
+#define GOVERNOR_DOWNGRADE_LOAD 0.95
+#define GOVERNOR_UPGRADE_LOAD 0.75
+
+// define for how many seconds the load has to stay beyond a threshold before the tier changes
+#define GOVERNOR_DOWNGRADE_DELAY 1.0
+#define GOVERNOR_MIN_UPGRADE_DELAY 5.0
+#define GOVERNOR_MAX_UPGRADE_DELAY 60.0
+
+// define for how many seconds the quality governor keeps a tier after changing it
+#define GOVERNOR_COOLDOWN 2.0
+
+// define after how many frames an open transition is ended by force
+#define MAX_TRANSITION_FRAMES 600
+
+// define how many frame times the sliding window of the frame statistics holds
+#define FRAME_TIME_COUNT 4096
+
+// define how often in seconds the frame statistics are recomputed
+#define FRAME_STATISTICS_INTERVAL 0.5
+
+// define how many trace events the ring holds
+#define TRACE_EVENT_COUNT 65536
+
+// define the smallest vignette radius scale
+#define MIN_VIGNETTE_RADIUS 0.01f
+
+// define range of supported color lookup table sizes
+#define MIN_LUT_SIZE 2
+#define MAX_LUT_SIZE 65
+
+static_assert((int) BLU_FX_PARAMETER_COUNT == (int) PARAMETER_MAX, "the public parameter block must match BLUfxPreset");
+
+// vertex-shader code, it stretches a unit quad over the part of the screen given by rect in normalized coordinates
+#define VERTEX_SHADER "attribute vec2 position;\n"\
+                      "uniform vec4 rect;\n"\
+                      "varying vec2 texCoord;\n"\
+                      "void main()\n"\
+                      "{\n"\
+                          "texCoord = mix(rect.xy, rect.zw, position);\n"\
+                          "gl_Position = vec4(texCoord * 2.0 - 1.0, 0.0, 1.0);\n"\
+                      "}\n"
+
+// fragment-shader code, every stage is gated by a preprocessor switch that is defined by the header of the respective shader permutation
+#define FRAGMENT_SHADER "const vec3 lumCoeff = vec3(0.2125, 0.7154, 0.0721);\n"\
+                        "uniform float brightness;\n"\
+                        "uniform float contrast;\n"\
+                        "uniform float saturation;\n"\
+                        "uniform float redScale;\n"\
+                        "uniform float greenScale;\n"\
+                        "uniform float blueScale;\n"\
+                        "uniform float redOffset;\n"\
+                        "uniform float greenOffset;\n"\
+                        "uniform float blueOffset;\n"\
+                        "uniform float vignette;\n"\
+                        "uniform float lutSize;\n"\
+                        "uniform sampler2D scene;\n"\
+                        "uniform sampler2D vignetteMask;\n"\
+                        "uniform sampler3D lut;\n"\
+                        "varying vec2 texCoord;\n"\
+                        "void main()\n"\
+                        "{\n"\
+                            "vec3 color = texture2D(scene, texCoord).rgb;\n"\
+                        "#if USE_LUT\n"\
+                            "color = texture3D(lut, color * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize).rgb;\n"\
+                        "#endif\n"\
+                        "#if ENABLE_CONTRAST_BRIGHTNESS\n"\
+                            "color *= contrast;\n"\
+                            "color += vec3(brightness, brightness, brightness);\n"\
+                        "#endif\n"\
+                        "#if ENABLE_SATURATION\n"\
+                            "vec3 intensity = vec3(dot(color, lumCoeff));\n"\
+                            "color = mix(intensity, color, saturation);\n"\
+                        "#endif\n"\
+                        "#if ENABLE_S_CURVE\n"\
+                            "vec3 newColor = (color.rgb - 0.5) * 2.0;\n"\
+                            "newColor.r = 2.0 / 3.0 * (1.0 - (newColor.r * newColor.r));\n"\
+                            "newColor.g = 2.0 / 3.0 * (1.0 - (newColor.g * newColor.g));\n"\
+                            "newColor.b = 2.0 / 3.0 * (1.0 - (newColor.b * newColor.b));\n"\
+                            "newColor.r = clamp(color.r + redScale * newColor.r + redOffset, 0.0, 1.0);\n"\
+                            "newColor.g = clamp(color.g + greenScale * newColor.g + greenOffset, 0.0, 1.0);\n"\
+                            "newColor.b = clamp(color.b + blueScale * newColor.b + blueOffset, 0.0, 1.0);\n"\
+                            "color = newColor;\n"\
+                        "#elif ENABLE_CONTRAST_BRIGHTNESS || ENABLE_SATURATION\n"\
+                            "color = clamp(color, 0.0, 1.0);\n"\
+                        "#endif\n"\
+                        "#if ENABLE_VIGNETTE\n"\
+                            "float vig = texture2D(vignetteMask, texCoord).r;\n"\
+                            "color = mix(color, color * vig, vignette);\n"\
+                        "#endif\n"\
+                            "gl_FragColor = vec4(color, 1.0);\n"\
+                        "}\n"
+
+// stages of the fragment-shader that can be compiled out, a shader permutation is a combination of these flags
+enum BLUfxShaderFeatures_t
+{
+    SHADER_FEATURE_CONTRAST_BRIGHTNESS = 1 << 0,
+    SHADER_FEATURE_SATURATION = 1 << 1,
+    SHADER_FEATURE_S_CURVE = 1 << 2,
+    SHADER_FEATURE_VIGNETTE = 1 << 3,
+    SHADER_FEATURE_LUT = 1 << 4,
+    SHADER_PERMUTATION_MAX = 1 << 5
+};
 
-enum BLUfxPresets_t
-{
-    PRESET_DEFAULT,
-    PRESET_POLAROID,
-    PRESET_FOGGED_UP,
-    PRESET_HIGH_DYNAMIC_RANGE,
-    PRESET_EDITORS_CHOICE,
-    PRESET_SLIGHTLY_ENHANCED,
-    PRESET_EXTRA_GLOOMY,
-    PRESET_RED_ISH,
-    PRESET_GREEN_ISH,
-    PRESET_BLUE_ISH,
-    PRESET_SHINY_CALIFORNIA,
-    PRESET_DUSTY_DRY,
-    PRESET_GRAY_WINTER,
-    PRESET_FANCY_IMAGINATION,
-    PRESET_SIXTIES,
-    PRESET_COLD_WINTER,
-    PRESET_VINTAGE_FILM,
-    PRESET_COLORLESS,
-    PRESET_MONOCHROME,
-    PRESET_MAX
+static const char *shaderFeatureDefines[] =
+{
+    "ENABLE_CONTRAST_BRIGHTNESS",
+    "ENABLE_SATURATION",
+    "ENABLE_S_CURVE",
+    "ENABLE_VIGNETTE",
+    "USE_LUT"
 };
 
-struct BLUfxPreset_t
-{
-    // basic
-    float brightness;
-    float contrast;
-    float saturation;
-    // scale
-    float redScale;
-    float greenScale;
-    float blueScale;
-    // offset
-    float redOffset;
-    float greenOffset;
-    float blueOffset;
-    // misc
-    float vignette;
+// uniforms of the fragment-shader, the first PARAMETER_MAX entries correspond to the fields of BLUfxPreset
+enum BLUfxUniforms_t
+{
+    UNIFORM_SCENE = PARAMETER_MAX,
+    UNIFORM_VIGNETTE_MASK,
+    UNIFORM_LUT,
+    UNIFORM_LUT_SIZE,
+    UNIFORM_RECT,
+    UNIFORM_MAX
 };
-typedef BLUfxPreset_t BLUfxPreset;
-
-BLUfxPreset BLUfxPresets [PRESET_MAX] =
-{
-    // PRESET_DEFAULT
-    {
-        0.0f, // brightness
-        1.0f, // contrast
-        1.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_POLAROID
-    {
-        0.05f, // brightness
-        1.1f, // contrast
-        1.4f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        -0.2f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.6f // vignette
-    },
-    // PRESET_FOGGED_UP
-    {
-        0.05f, // brightness
-        1.2f, // contrast
-        0.7f, // saturation
-        0.15f, // red scale
-        0.15f, // green scale
-        0.15f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.3f // vignette
-    },
-    // PRESET_HIGH_DYNAMIC_RANGE
-    {
-        0.0f, // brightness
-        1.15f, // contrast
-        0.9f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.6f // vignette
-    },
-    // PRESET_EDITORS_CHOICE
-    {
-        0.05f, // brightness
-        1.1f, // contrast
-        1.3f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.3f // vignette
-    },
-    // PRESET_SLIGHTLY_ENHANCED
-    {
-        0.05f, // brightness
-        1.1f, // contrast
-        1.1f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_EXTRA_GLOOMY
-    {
-        -0.15f, // brightness
-        1.3f, // contrast
-        1.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_RED_ISH
-    {
-        0.0f, // brightness
-        1.0f, // contrast
-        1.0f, // saturation
-        0.1f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_GREEN_ISH
-    {
-        0.0f, // brightness
-        1.0f, // contrast
-        1.0f, // saturation
-        0.0f, // red scale
-        0.1f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_BLUE_ISH
-    {
-        0.0f, // brightness
-        1.0f, // contrast
-        1.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.1f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_SHINY_CALIFORNIA
-    {
-        0.1f, // brightness
-        1.5f, // contrast
-        1.3f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        -0.1f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_DUSTY_DRY
-    {
-        0.0f, // brightness
-        1.3f, // contrast
-        1.3f, // saturation
-        0.2f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.0f, // green offset
-        0.0f, // blue offset
-        0.6f // vignette
-    },
-    // PRESET_GRAY_WINTER
-    {
-        0.07f, // brightness
-        1.15f, // contrast
-        1.3f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.05f, // green offset
-        0.0f, // blue offset
-        0.6f // vignette
-    },
-    // PRESET_FANCY_IMAGINATION
-    {
-        0.0f, // brightness
-        1.6f, // contrast
-        1.5f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        -0.1f, // blue scale
-        0.0f, // red offset
-        0.05f, // green offset
-        0.0f, // blue offset
-        0.6f // vignette
-    },
-    // PRESET_SIXTIES
-    {
-        0.0f, // brightness
-        1.6f, // contrast
-        1.5f, // saturation
-        0.2f, // red scale
-        0.0f, // green scale
-        -0.1f, // blue scale
-        0.0f, // red offset
-        0.05f, // green offset
-        0.0f, // blue offset
-        0.65f // vignette
-    },
-    // PRESET_COLD_WINTER
-    {
-        0.0f, // brightness
-        1.55f, // contrast
-        0.0f, // saturation
-        0.0f, // red scale
-        0.05f, // green scale
-        0.2f, // blue scale
-        0.0f, // red offset
-        0.05f, // green offset
-        0.0f, // blue offset
-        0.25f // vignette
-    },
-    // PRESET_VINTAGE_FILM
-    {
-        0.0f, // brightness
-        1.05f, // contrast
-        0.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.07f, // blue scale
-        0.07f, // red offset
-        0.03f, // green offset
-        0.0f, // blue offset
-        0.0f // vignette
-    },
-    // PRESET_COLORLESS
-    {
-        -0.03f, // brightness
-        1.3f, // contrast
-        0.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.03f, // green offset
-        0.0f, // blue offset
-        0.65f // vignette
-    },
-    // PRESET_MONOCHROME
-    {
-        -0.13f, // brightness
-        1.2f, // contrast
-        0.0f, // saturation
-        0.0f, // red scale
-        0.0f, // green scale
-        0.0f, // blue scale
-        0.0f, // red offset
-        0.03f, // green offset
-        0.0f, // blue offset
-        0.7f // vignette
-    }
+
+static const char *uniformNames[UNIFORM_MAX] =
+{
+    "brightness",
+    "contrast",
+    "saturation",
+    "redScale",
+    "greenScale",
+    "blueScale",
+    "redOffset",
+    "greenOffset",
+    "blueOffset",
+    "vignette",
+    "scene",
+    "vignetteMask",
+    "lut",
+    "lutSize",
+    "rect"
+};
+
+// a linked shader-program together with its resolved uniform locations and the uniform values that were last uploaded to it
+struct BLUfxShaderProgram_t
+{
+    int initialized;
+    GLuint program;
+    GLint uniformLocations[UNIFORM_MAX];
+    BLUfxPreset uploadedParameters;
+    float uploadedRect[4];
+    int uniformsDirty;
+};
+typedef BLUfxShaderProgram_t BLUfxShaderProgram;
+
+// a full-screen texture managed by the render target pool
+struct BLUfxRenderTarget_t
+{
+    GLuint texture;
+    int width;
+    int height;
+    GLenum internalFormat;
+    int inUse;
+};
+typedef BLUfxRenderTarget_t BLUfxRenderTarget;
+
+// passes of the post-processing whose GPU time is measured
+enum BLUfxGpuTimers_t
+{
+    GPU_TIMER_COPY,
+    GPU_TIMER_SHADE,
+    GPU_TIMER_MAX
+};
+
+static const char *gpuTimerNames[GPU_TIMER_MAX] =
+{
+    "copy",
+    "shade"
+};
+
+// statistics that are published for every measured pass
+enum BLUfxGpuStatistics_t
+{
+    GPU_STATISTIC_AVERAGE,
+    GPU_STATISTIC_MAXIMUM,
+    GPU_STATISTIC_P99,
+    GPU_STATISTIC_MAX
+};
+
+static const char *gpuStatisticNames[GPU_STATISTIC_MAX] =
+{
+    "avg",
+    "max",
+    "p99"
+};
+
+// a ring of timer queries around one pass and its GPU times in milliseconds
+struct BLUfxGpuTimer_t
+{
+    GLuint queries[GPU_TIMER_QUERY_COUNT];
+    int pending[GPU_TIMER_QUERY_COUNT];
+    int nextQuery;
+    int active;
+    float samples[GPU_TIMER_SAMPLE_COUNT];
+    int sampleCount;
+    int nextSample;
+    float statistics[GPU_STATISTIC_MAX];
+};
+typedef BLUfxGpuTimer_t BLUfxGpuTimer;
+
+// callbacks whose main-thread time is measured
+enum BLUfxCallbacks_t
+{
+    CALLBACK_POST_PROCESSING,
+    CALLBACK_LIMITER_DRAW,
+    CALLBACK_LIMITER_FLIGHT,
+    CALLBACK_CONTROL_CINEMA_VERITE,
+    CALLBACK_UPDATE_FAKE_WINDOW,
+    CALLBACK_FRAME_STATISTICS,
+    CALLBACK_MAX
+};
+
+static const char *callbackNames[CALLBACK_MAX] =
+{
+    "post_processing",
+    "limiter_draw",
+    "limiter_flight",
+    "control_cinema_verite",
+    "update_fake_window",
+    "frame_statistics"
+};
+
+// statistics that are published for every measured callback
+enum BLUfxCpuStatistics_t
+{
+    CPU_STATISTIC_CALLS,
+    CPU_STATISTIC_AVERAGE,
+    CPU_STATISTIC_P50,
+    CPU_STATISTIC_P99,
+    CPU_STATISTIC_MAXIMUM,
+    CPU_STATISTIC_HISTOGRAM,
+    CPU_STATISTIC_MAX
 };
 
-// fragment-shader code
-#define FRAGMENT_SHADER "#version 120\n"\
-                        "const vec3 lumCoeff = vec3(0.2125, 0.7154, 0.0721);"\
-                        "uniform float brightness;"\
-                        "uniform float contrast;"\
-                        "uniform float saturation;"\
-                        "uniform float redScale;"\
-                        "uniform float greenScale;"\
-                        "uniform float blueScale;"\
-                        "uniform float redOffset;"\
-                        "uniform float greenOffset;"\
-                        "uniform float blueOffset;"\
-                        "uniform vec2 resolution;"\
-                        "uniform float vignette;"\
-                        "uniform sampler2D scene;"\
-                        "void main()"\
-                        "{"\
-                            "vec3 color = texture2D(scene, gl_TexCoord[0].st).rgb;"\
-                            "color *= contrast;"\
-                            "color += vec3(brightness, brightness, brightness);"\
-                            "vec3 intensity = vec3(dot(color, lumCoeff));"\
-                            "color = mix(intensity, color, saturation);"\
-                            "vec3 newColor = (color.rgb - 0.5) * 2.0;"\
-                            "newColor.r = 2.0 / 3.0 * (1.0 - (newColor.r * newColor.r));"\
-                            "newColor.g = 2.0 / 3.0 * (1.0 - (newColor.g * newColor.g));"\
-                            "newColor.b = 2.0 / 3.0 * (1.0 - (newColor.b * newColor.b));"\
-                            "newColor.r = clamp(color.r + redScale * newColor.r + redOffset, 0.0, 1.0);"\
-                            "newColor.g = clamp(color.g + greenScale * newColor.g + greenOffset, 0.0, 1.0);"\
-                            "newColor.b = clamp(color.b + blueScale * newColor.b + blueOffset, 0.0, 1.0);"\
-                            "color = newColor;"\
-                            "vec2 position = (gl_FragCoord.xy / resolution.xy) - vec2(0.5);"\
-                            "float len = length(position);"\
-                            "float vig = smoothstep(0.75, 0.75 - 0.45, len);"\
-                            "color = mix(color, color * vig, vignette);"\
-                            "gl_FragColor = vec4(color, 1.0);"\
-                        "}"
+static const char *cpuStatisticNames[CPU_STATISTIC_MAX] =
+{
+    "calls",
+    "avg_ms",
+    "p50_ms",
+    "p99_ms",
+    "max_ms",
+    "histogram"
+};
+
+// a log-linear histogram of call durations in microseconds
+struct BLUfxHistogram_t
+{
+    int buckets[HISTOGRAM_BUCKET_COUNT];
+    int count;
+    double sum;
+    double maximum;
+};
+typedef BLUfxHistogram_t BLUfxHistogram;
+
+// state of the frame limiter, shared by all of its hooks
+struct BLUfxLimiter_t
+{
+    int lastCycle;
+    double deadline;
+    double sleepTime;
+    double lastFrameTime;
+    double frameTimeMean;
+    double frameTimeVariance;
+};
+typedef BLUfxLimiter_t BLUfxLimiter;
+
+// sim DataRefs that are read and written through the DataRef cache
+enum BLUfxSimDataRefs_t
+{
+    SIM_DATAREF_VIEW_TYPE,
+    SIM_DATAREF_CINEMA_VERITE,
+    SIM_DATAREF_RALEIGH_SCALE,
+    SIM_DATAREF_MAX
+};
+
+// cached state of a sim DataRef, the value is the last one that was read or written and readFrame is the cache frame in which it was read
+struct BLUfxCachedDataRef_t
+{
+    const char *name;
+    XPLMDataTypeID type;
+    XPLMDataRef dataRef;
+    int valueKnown;
+    int dirty;
+    unsigned int readFrame;
+    int intValue;
+    float floatValue;
+};
+typedef BLUfxCachedDataRef_t BLUfxCachedDataRef;
+
+// counters of the XPLM calls the DataRef cache saved in a frame
+enum BLUfxDataRefCacheStatistics_t
+{
+    DATAREF_CACHE_READS_SAVED,
+    DATAREF_CACHE_WRITES_SAVED,
+    DATAREF_CACHE_STATISTIC_MAX
+};
+
+static const char *dataRefCacheStatisticNames[DATAREF_CACHE_STATISTIC_MAX] =
+{
+    "reads_saved",
+    "writes_saved"
+};
+
+// easing curves of the crossfade between two sets of parameters
+enum BLUfxPresetTransitionEasings_t
+{
+    PRESET_TRANSITION_EASING_LINEAR,
+    PRESET_TRANSITION_EASING_EASE_IN,
+    PRESET_TRANSITION_EASING_EASE_OUT,
+    PRESET_TRANSITION_EASING_EASE_IN_OUT,
+    PRESET_TRANSITION_EASING_MAX
+};
+
+// state of the crossfade between two sets of parameters
+struct BLUfxPresetTransition_t
+{
+    int active;
+    int preset;
+    BLUfxPreset from;
+    BLUfxPreset to;
+    double startTime;
+    double duration;
+    float progress;
+};
+typedef BLUfxPresetTransition_t BLUfxPresetTransition;
+
+// tasks that are run by the flightloop dispatcher
+enum BLUfxTasks_t
+{
+    TASK_UPDATE_FAKE_WINDOW,
+    TASK_BRING_FAKE_WINDOW_TO_FRONT,
+    TASK_LIMITER,
+    TASK_CONTROL_CINEMA_VERITE,
+    TASK_MAX
+};
+
+// an entry of the schedule of the flightloop dispatcher, the schedule is a min-heap ordered by the fire time on the monotonic clock
+struct BLUfxScheduledTask_t
+{
+    double fireTime;
+    int task;
+};
+typedef BLUfxScheduledTask_t BLUfxScheduledTask;
+
+// quality tiers of the post-processing, ordered from the most to the least expensive
+enum BLUfxQualityTiers_t
+{
+    QUALITY_TIER_FULL,
+    QUALITY_TIER_HALF_RESOLUTION,
+    QUALITY_TIER_REDUCED,
+    QUALITY_TIER_BYPASS,
+    QUALITY_TIER_MAX
+};
+
+static const char *qualityTierNames[QUALITY_TIER_MAX] =
+{
+    "full resolution",
+    "half resolution",
+    "reduced stages",
+    "bypass"
+};
+
+// statistics that are computed over the sliding window of frame times
+enum BLUfxFrameStatistics_t
+{
+    FRAME_STATISTIC_AVERAGE_FPS,
+    FRAME_STATISTIC_ONE_PERCENT_LOW_FPS,
+    FRAME_STATISTIC_POINT_ONE_PERCENT_LOW_FPS,
+    FRAME_STATISTIC_FRAME_TIME_DEVIATION,
+    FRAME_STATISTIC_MAX
+};
+
+static const char *frameStatisticNames[FRAME_STATISTIC_MAX] =
+{
+    "avg_fps",
+    "one_percent_low_fps",
+    "point_one_percent_low_fps",
+    "frame_time_sd_ms"
+};
+
+// a completed span of plugin activity, name and category must be string literals
+struct BLUfxTraceEvent_t
+{
+    const char *name;
+    const char *category;
+    double startTime;
+    double endTime;
+};
+typedef BLUfxTraceEvent_t BLUfxTraceEvent;
+
+// ways of copying the rendered scene into the scene texture
+enum BLUfxSceneCopyPaths_t
+{
+    SCENE_COPY_PATH_UNKNOWN = -1,
+    SCENE_COPY_PATH_COPY_TEX_SUB_IMAGE,
+    SCENE_COPY_PATH_BLIT_FRAMEBUFFER,
+    SCENE_COPY_PATH_MAX
+};
+
+static const char *sceneCopyPathNames[SCENE_COPY_PATH_MAX] =
+{
+    "glCopyTexSubImage2D",
+    "glBlitFramebuffer"
+};
+
+// number of copies per path that are timed when probing for the fastest scene copy path
+#define SCENE_COPY_PROBE_ITERATIONS 8
 
 // global settings variables
-static int postProcesssingEnabled = DEFAULT_POST_PROCESSING_ENABLED, fpsLimiterEnabled = DEFAULT_FPS_LIMITER_ENABLED, controlCinemaVeriteEnabled = DEFAULT_CONTROL_CINEMA_VERITE_ENABLED;
-static float maxFps = DEFAULT_MAX_FRAME_RATE, disableCinemaVeriteTime = DEFAULT_DISABLE_CINEMA_VERITE_TIME, brightness = BLUfxPresets[PRESET_DEFAULT].brightness, contrast = BLUfxPresets[PRESET_DEFAULT].contrast, saturation = BLUfxPresets[PRESET_DEFAULT].saturation, redScale = BLUfxPresets[PRESET_DEFAULT].redScale, greenScale = BLUfxPresets[PRESET_DEFAULT].greenScale, blueScale = BLUfxPresets[PRESET_DEFAULT].blueScale, redOffset = BLUfxPresets[PRESET_DEFAULT].redOffset, greenOffset = BLUfxPresets[PRESET_DEFAULT].greenOffset, blueOffset = BLUfxPresets[PRESET_DEFAULT].blueOffset, vignette = BLUfxPresets[PRESET_DEFAULT].vignette, raleighScale = DEFAULT_RALEIGH_SCALE;
+static int postProcesssingEnabled = DEFAULT_POST_PROCESSING_ENABLED, fpsLimiterEnabled = DEFAULT_FPS_LIMITER_ENABLED, controlCinemaVeriteEnabled = DEFAULT_CONTROL_CINEMA_VERITE_ENABLED, lutEnabled = DEFAULT_LUT_ENABLED, lutSize = DEFAULT_LUT_SIZE, tracingEnabled = DEFAULT_TRACING_ENABLED, frameStatisticsOverlayEnabled = DEFAULT_FRAME_STATISTICS_OVERLAY_ENABLED, qualityGovernorEnabled = DEFAULT_QUALITY_GOVERNOR_ENABLED, presetTransitionEasing = DEFAULT_PRESET_TRANSITION_EASING;
+static float maxFps = DEFAULT_MAX_FRAME_RATE, presetTransitionTime = DEFAULT_PRESET_TRANSITION_TIME, disableCinemaVeriteTime = DEFAULT_DISABLE_CINEMA_VERITE_TIME, raleighScale = DEFAULT_RALEIGH_SCALE, vignetteCenterX = DEFAULT_VIGNETTE_CENTER_X, vignetteCenterY = DEFAULT_VIGNETTE_CENTER_Y, vignetteRadiusX = DEFAULT_VIGNETTE_RADIUS_X, vignetteRadiusY = DEFAULT_VIGNETTE_RADIUS_Y;
+static BLUfxPreset parameters = BLUfxPresets[PRESET_DEFAULT];
 
 // global internal variables
-static int lastResolutionX = 0, lastResolutionY = 0, bringFakeWindowToFront = 0, overrideControlCinemaVerite = 0;
-static GLuint textureId = 0, program = 0, fragmentShader = 0;
-static float startTimeFlight = 0.0f, endTimeFlight = 0.0f, startTimeDraw = 0.0f, endTimeDraw = 0.0f, lastMouseUsageTime = 0.0f;
+static int lastResolutionX = 0, lastResolutionY = 0, fakeWindowWidth = 0, fakeWindowHeight = 0, overrideControlCinemaVerite = 0, bypassedFrames = 0, settingsWidgetsStale = 0;
+static BLUfxPreset pendingParameters;
+static int pendingParametersValid = 0, transitionDepth = 0, transitionFrames = 0;
+static BLUfxPresetTransition presetTransition = {0, -1};
+static int sceneCopyPath = SCENE_COPY_PATH_UNKNOWN;
+static int lutTextureSize = 0, vignetteMaskWidth = 0, vignetteMaskHeight = 0;
+static float vignetteMaskShape[4] = {0.0f};
+static GLuint textureId = 0, sceneFramebuffer = 0, processedTextureId = 0, processedFramebuffer = 0, lutTextureId = 0, vignetteMaskTextureId = 0, quadVertexBuffer = 0;
+static int qualityTier = QUALITY_TIER_FULL, processedWidth = 0, processedHeight = 0, governorSkippedFrames = 0;
+static double governorLoad = 0.0, governorOverBudgetTime = 0.0, governorUnderBudgetTime = 0.0, governorLastChangeTime = 0.0, governorLastUpgradeTime = 0.0, governorUpgradeDelay = GOVERNOR_MIN_UPGRADE_DELAY;
+static BLUfxShaderProgram shaderPrograms[SHADER_PERMUTATION_MAX] = {{0}};
+static BLUfxPreset lutParameters;
+static float lastMouseUsageTime = 0.0f;
+static int lastCinemaVerite = -1, lastViewType = -1;
+static BLUfxLimiter limiter = {-1, 0.0};
+static double spinThreshold = DEFAULT_SPIN_THRESHOLD, wakeUpErrorMean = 0.0, wakeUpErrorDeviation = 0.0;
 static XPLMWindowID fakeWindow = NULL;
+static XPLMFlightLoopID dispatcherFlightLoop = NULL;
+static BLUfxCachedDataRef cachedDataRefs[SIM_DATAREF_MAX] =
+{
+    {"sim/graphics/view/view_type", xplmType_Int},
+    {"sim/graphics/view/cinema_verite", xplmType_Int},
+    {"sim/private/controls/atmo/atmo_scale_raleigh", xplmType_Float}
+};
+static unsigned int dataRefCacheFrame = 1;
+static int dataRefCacheCounters[DATAREF_CACHE_STATISTIC_MAX] = {0}, dataRefCacheStatistics[DATAREF_CACHE_STATISTIC_MAX] = {0};
+static BLUfxScheduledTask scheduledTasks[TASK_MAX];
+static int scheduledTaskCount = 0, dispatchingTasks = 0;
+static int programBinarySupported = -1;
+static GetProgramBinaryProc getProgramBinary = NULL;
+static ProgramBinaryProc programBinary = NULL;
+static ProgramParameteriProc programParameteri = NULL;
+static int textureStorageSupported = -1, renderTargetMemory = 0;
+static TexStorage2DProc texStorage2D = NULL;
+static BLUfxRenderTarget renderTargets[MAX_RENDER_TARGETS] = {{0}};
+static int gpuTimerSupported = -1;
+static GetQueryObjectui64vProc getQueryObjectui64v = NULL;
+static BLUfxGpuTimer gpuTimers[GPU_TIMER_MAX] = {{{0}}};
+static int vertexArrayObjectSupported = -1;
+static BindVertexArrayProc bindVertexArray = NULL;
+static BLUfxHistogram callbackHistograms[CALLBACK_MAX] = {{{0}}};
+static BLUfxTraceEvent *traceEvents = NULL;
+static std::atomic<unsigned int> traceEventIndex(0);
+static XPLMMenuID menu = NULL;
+static XPLMCommandRef nextPresetCommand = NULL, previousPresetCommand = NULL;
+static float frameTimes[FRAME_TIME_COUNT] = {0.0f}, frameStatistics[FRAME_STATISTIC_MAX] = {0.0f};
+static int frameTimeCount = 0, nextFrameTime = 0;
+static double lastFrameTime = 0.0, lastFrameStatisticsTime = 0.0;
 
 // global dataref variables
-static XPLMDataRef cinemaVeriteDataRef = NULL, viewTypeDataRef = NULL, raleighScaleDataRef = NULL, overrideControlCinemaVeriteDataRef = NULL, ignitionKeyDataRef = NULL;
+static XPLMDataRef overrideControlCinemaVeriteDataRef = NULL, presetTransitionPresetDataRef = NULL, presetTransitionTargetDataRef = NULL, presetTransitionTimeDataRef = NULL, presetTransitionEasingDataRef = NULL, presetTransitionProgressDataRef = NULL, parameterDataRefs[PARAMETER_MAX] = {NULL}, parametersDataRef = NULL, raleighScaleDataRef = NULL, maxFpsDataRef = NULL, ignitionKeyDataRef = NULL, bypassedFramesDataRef = NULL, renderTargetMemoryDataRef = NULL, frameTimeVarianceDataRef = NULL, measuredFpsDataRef = NULL, spinThresholdDataRef = NULL, gpuTimerDataRefs[GPU_TIMER_MAX][GPU_STATISTIC_MAX] = {{NULL}}, cpuTimerDataRefs[CALLBACK_MAX][CPU_STATISTIC_MAX] = {{NULL}}, frameStatisticDataRefs[FRAME_STATISTIC_MAX] = {NULL}, dataRefCacheStatisticDataRefs[DATAREF_CACHE_STATISTIC_MAX] = {NULL}, qualityGovernorEnabledDataRef = NULL, qualityTierDataRef = NULL, governorSkippedFramesDataRef = NULL;
 
 // global widget variables
 static XPWidgetID settingsWidget = NULL, postProcessingCheckbox = NULL, fpsLimiterCheckbox = NULL, controlCinemaVeriteCheckbox = NULL, brightnessCaption = NULL, contrastCaption = NULL, saturationCaption = NULL, redScaleCaption = NULL, greenScaleCaption = NULL, blueScaleCaption = NULL, redOffsetCaption = NULL, greenOffsetCaption = NULL, blueOffsetCaption = NULL, vignetteCaption = NULL, raleighScaleCaption = NULL, maxFpsCaption = NULL, disableCinemaVeriteTimeCaption, brightnessSlider = NULL, contrastSlider = NULL, saturationSlider = NULL, redScaleSlider = NULL, greenScaleSlider = NULL, blueScaleSlider = NULL, redOffsetSlider = NULL, greenOffsetSlider = NULL, blueOffsetSlider = NULL, vignetteSlider = NULL, raleighScaleSlider = NULL, maxFpsSlider = NULL, disableCinemaVeriteTimeSlider = NULL, presetButtons[PRESET_MAX] = {NULL}, resetRaleighScaleButton = NULL;
 
-// draw-callback that adds post-processing
-static int PostProcessingCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
+// returns a timestamp in seconds from a monotonic high-resolution clock
+static double GetMonotonicTime(void)
+{
+#if IBM
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+// stores a span in the trace ring
+static void AddTraceEvent(const char *name, const char *category, double startTime, double endTime)
+{
+    if (traceEvents == NULL)
+        return;
+
+    BLUfxTraceEvent *traceEvent = &traceEvents[traceEventIndex.fetch_add(1, std::memory_order_relaxed) % TRACE_EVENT_COUNT];
+    traceEvent->name = name;
+    traceEvent->category = category;
+    traceEvent->startTime = startTime;
+    traceEvent->endTime = endTime;
+}
+
+// records the span from its construction to its destruction in the trace ring
+struct BLUfxTraceScope_t
+{
+    const char *name;
+    const char *category;
+    double startTime;
+
+    BLUfxTraceScope_t(const char *name, const char *category) : name(name), category(category), startTime(tracingEnabled ? GetMonotonicTime() : 0.0)
+    {
+    }
+
+    ~BLUfxTraceScope_t()
+    {
+        if (tracingEnabled && startTime != 0.0)
+            AddTraceEvent(name, category, startTime, GetMonotonicTime());
+    }
+};
+typedef BLUfxTraceScope_t BLUfxTraceScope;
+
+// enables or disables tracing and restarts the trace ring
+static void SetTracingEnabled(int enabled)
+{
+    if (enabled && !tracingEnabled)
+    {
+        if (traceEvents == NULL)
+            traceEvents = new BLUfxTraceEvent[TRACE_EVENT_COUNT];
+        traceEventIndex.store(0);
+    }
+
+    tracingEnabled = enabled;
+
+    if (menu != NULL)
+        XPLMCheckMenuItem(menu, 1, tracingEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+}
+
+// writes the contents of the trace ring as Chrome trace-event JSON
+static void SaveTrace(void)
+{
+    if (traceEvents == NULL)
+    {
+        XPLMDebugString(NAME": There is no trace to save, tracing was never enabled\n");
+        return;
+    }
+
+    std::fstream file;
+    file.open(TRACE_PATH, std::ios_base::out | std::ios_base::trunc);
+
+    if(file.is_open())
+    {
+        unsigned int index = traceEventIndex.load();
+        unsigned int first = index > TRACE_EVENT_COUNT ? index - TRACE_EVENT_COUNT : 0;
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+        for (unsigned int i = first; i < index; i++)
+        {
+            const BLUfxTraceEvent *traceEvent = &traceEvents[i % TRACE_EVENT_COUNT];
+
+            char line[256];
+            sprintf(line, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s", traceEvent->name, traceEvent->category, traceEvent->startTime * 1000000.0, (traceEvent->endTime - traceEvent->startTime) * 1000000.0, i + 1 < index ? "," : "");
+            file << line << std::endl;
+        }
+        file << "]}" << std::endl;
+
+        file.close();
+
+        char message[64];
+        sprintf(message, NAME": Saved %u trace events\n", index - first);
+        XPLMDebugString(message);
+    }
+}
+
+// returns the histogram bucket of a duration in microseconds
+static int GetHistogramBucket(double microseconds)
+{
+    unsigned int value = microseconds < (double) 0xFFFFFFFF ? (unsigned int) microseconds : 0xFFFFFFFF;
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return (int) value;
+
+    int octave = 0;
+    while ((value >> octave) > 1)
+        octave++;
+
+    int bucket = (octave - 1) * HISTOGRAM_SUB_BUCKETS + (int) ((value >> (octave - 2)) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+    return bucket < HISTOGRAM_BUCKET_COUNT ? bucket : HISTOGRAM_BUCKET_COUNT - 1;
+}
+
+// returns the upper bound of a histogram bucket in microseconds
+static double GetHistogramBucketLimit(int bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+        return bucket + 1.0;
+
+    int octave = bucket / HISTOGRAM_SUB_BUCKETS + 1;
+
+    return (double) ((HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS + 1) << (octave - 2));
+}
+
+// adds a duration in microseconds to a histogram
+static void AddHistogramSample(BLUfxHistogram *histogram, double microseconds)
+{
+    histogram->buckets[GetHistogramBucket(microseconds)]++;
+    histogram->count++;
+    histogram->sum += microseconds;
+    if (microseconds > histogram->maximum)
+        histogram->maximum = microseconds;
+}
+
+// estimates a percentile of a histogram in milliseconds
+static float GetHistogramPercentile(const BLUfxHistogram *histogram, float percentile)
+{
+    int rank = (int) (histogram->count * percentile + 0.999f), count = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        count += histogram->buckets[i];
+        if (count >= rank && count > 0)
+            return (float) (std::min(GetHistogramBucketLimit(i), histogram->maximum) / 1000.0);
+    }
+
+    return 0.0f;
+}
+
+// measures the time from its construction to its destruction and adds it to the histogram of a callback
+struct BLUfxScopeTimer_t
+{
+    int callback;
+    double startTime;
+
+    BLUfxScopeTimer_t(int callback) : callback(callback), startTime(GetMonotonicTime())
+    {
+    }
+
+    ~BLUfxScopeTimer_t()
+    {
+        double endTime = GetMonotonicTime();
+        AddHistogramSample(&callbackHistograms[callback], (endTime - startTime) * 1000000.0);
+
+        if (tracingEnabled)
+            AddTraceEvent(callbackNames[callback], "callback", startTime, endTime);
+    }
+};
+typedef BLUfxScopeTimer_t BLUfxScopeTimer;
+
+// writes a table of the timing statistics of all callbacks to the log
+static void LogCallbackStatistics(void)
+{
+    char line[160];
+    sprintf(line, NAME": %-24s %10s %10s %10s %10s %10s\n", "Callback", "Calls", "Avg ms", "P50 ms", "P99 ms", "Max ms");
+    XPLMDebugString(line);
+
+    for (int i = 0; i < CALLBACK_MAX; i++)
+    {
+        const BLUfxHistogram *histogram = &callbackHistograms[i];
+        sprintf(line, NAME": %-24s %10d %10.3f %10.3f %10.3f %10.3f\n", callbackNames[i], histogram->count, histogram->count > 0 ? histogram->sum / histogram->count / 1000.0 : 0.0, GetHistogramPercentile(histogram, 0.5f), GetHistogramPercentile(histogram, 0.99f), histogram->maximum / 1000.0);
+        XPLMDebugString(line);
+    }
+}
+
+// returns the version of the current OpenGL context encoded as major * 10 + minor
+static int GetGLVersion(void)
+{
+    const char *versionString = (const char *) glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+
+    if (versionString == NULL || sscanf(versionString, "%d.%d", &major, &minor) != 2)
+        return 0;
+
+    return major * 10 + minor;
+}
+
+// checks if the current OpenGL context advertises the given extension
+static int IsGLExtensionSupported(const char *extension)
+{
+    const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+    if (extensions == NULL)
+        return 0;
+
+    size_t length = strlen(extension);
+    const char *position = extensions;
+    while ((position = strstr(position, extension)) != NULL)
+    {
+        if ((position == extensions || position[-1] == ' ') && (position[length] == ' ' || position[length] == '\0'))
+            return 1;
+
+        position += length;
+    }
+
+    return 0;
+}
+
+// returns the address of an OpenGL entry point of the current context or NULL if it is not available
+static void *GetGLProcAddress(const char *name)
+{
+#if IBM
+    return (void *) wglGetProcAddress(name);
+#else
+#if LIN
+    typedef void *(*GetProcAddressProc)(const GLubyte *name);
+    static GetProcAddressProc getProcAddress = (GetProcAddressProc) dlsym(RTLD_DEFAULT, "glXGetProcAddressARB");
+    if (getProcAddress != NULL)
+        return getProcAddress((const GLubyte *) name);
+#endif
+    return dlsym(RTLD_DEFAULT, name);
+#endif
+}
+
+// sums up the video memory occupied by all render targets of the pool, all of them are RGBA8 so every texel takes four bytes
+static void UpdateRenderTargetMemory(void)
+{
+    renderTargetMemory = 0;
+    for (int i = 0; i < MAX_RENDER_TARGETS; i++)
+    {
+        if (renderTargets[i].texture != 0)
+            renderTargetMemory += renderTargets[i].width * renderTargets[i].height * 4;
+    }
+}
+
+// deletes the texture of a render target and marks its slot as empty
+static void DeleteRenderTarget(BLUfxRenderTarget *renderTarget)
+{
+    glDeleteTextures(1, &renderTarget->texture);
+    memset(renderTarget, 0, sizeof(BLUfxRenderTarget));
+}
+
+// returns a texture of the given size and format from the render target pool and leaves it bound to the active texture unit, idle targets that do not match are deleted because the screen size they were made for is gone
+static GLuint AcquireRenderTarget(int width, int height, GLenum internalFormat)
+{
+    if (textureStorageSupported == -1)
+    {
+        texStorage2D = GetGLVersion() >= 42 || IsGLExtensionSupported("GL_ARB_texture_storage") ? (TexStorage2DProc) GetGLProcAddress("glTexStorage2D") : NULL;
+        textureStorageSupported = texStorage2D != NULL;
+    }
+
+    BLUfxRenderTarget *freeSlot = NULL;
+    for (int i = 0; i < MAX_RENDER_TARGETS; i++)
+    {
+        BLUfxRenderTarget *renderTarget = &renderTargets[i];
+        if (renderTarget->inUse)
+            continue;
+
+        if (renderTarget->texture != 0 && renderTarget->width == width && renderTarget->height == height && renderTarget->internalFormat == internalFormat)
+        {
+            renderTarget->inUse = 1;
+            glBindTexture(GL_TEXTURE_2D, renderTarget->texture);
+
+            // idle targets in earlier slots may just have been deleted
+            UpdateRenderTargetMemory();
+
+            return renderTarget->texture;
+        }
+
+        if (renderTarget->texture != 0)
+            DeleteRenderTarget(renderTarget);
+
+        if (freeSlot == NULL)
+            freeSlot = renderTarget;
+    }
+
+    if (freeSlot == NULL)
+    {
+        XPLMDebugString(NAME": The render target pool is exhausted\n");
+        return 0;
+    }
+
+    BLUfxTraceScope traceScope("AcquireRenderTarget", "gl");
+
+    XPLMGenerateTextureNumbers((int *) &freeSlot->texture, 1);
+    glBindTexture(GL_TEXTURE_2D, freeSlot->texture);
+    if (textureStorageSupported)
+        texStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    freeSlot->width = width;
+    freeSlot->height = height;
+    freeSlot->internalFormat = internalFormat;
+    freeSlot->inUse = 1;
+    UpdateRenderTargetMemory();
+
+    return freeSlot->texture;
+}
+
+// hands a texture back to the render target pool, it is kept until a target of a different size or format is requested
+static void ReleaseRenderTarget(GLuint texture)
+{
+    for (int i = 0; i < MAX_RENDER_TARGETS; i++)
+    {
+        if (texture != 0 && renderTargets[i].texture == texture)
+            renderTargets[i].inUse = 0;
+    }
+}
+
+// deletes all render targets of the pool
+static void CleanupRenderTargets(void)
+{
+    for (int i = 0; i < MAX_RENDER_TARGETS; i++)
+    {
+        if (renderTargets[i].texture != 0)
+            DeleteRenderTarget(&renderTargets[i]);
+    }
+
+    UpdateRenderTargetMemory();
+}
+
+// recomputes the published statistics of a timer from its current samples
+static void UpdateGpuTimerStatistics(BLUfxGpuTimer *timer)
+{
+    float sortedSamples[GPU_TIMER_SAMPLE_COUNT];
+    memcpy(sortedSamples, timer->samples, timer->sampleCount * sizeof(float));
+
+    float sum = 0.0f;
+    for (int i = 0; i < timer->sampleCount; i++)
+        sum += sortedSamples[i];
+
+    int p99Index = (timer->sampleCount * 99) / 100;
+    std::nth_element(sortedSamples, sortedSamples + p99Index, sortedSamples + timer->sampleCount);
+
+    timer->statistics[GPU_STATISTIC_AVERAGE] = sum / timer->sampleCount;
+    timer->statistics[GPU_STATISTIC_MAXIMUM] = *std::max_element(sortedSamples, sortedSamples + timer->sampleCount);
+    timer->statistics[GPU_STATISTIC_P99] = sortedSamples[p99Index];
+}
+
+// reads back the results of all finished queries of a timer without waiting for the GPU
+static void CollectGpuTimer(BLUfxGpuTimer *timer)
+{
+    int collected = 0;
+
+    for (int i = 0; i < GPU_TIMER_QUERY_COUNT; i++)
+    {
+        int query = (timer->nextQuery + i) % GPU_TIMER_QUERY_COUNT;
+        if (!timer->pending[query])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(timer->queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        unsigned long long elapsedTime = 0;
+        getQueryObjectui64v(timer->queries[query], GL_QUERY_RESULT, &elapsedTime);
+        timer->pending[query] = 0;
+
+        timer->samples[timer->nextSample] = (float) (elapsedTime / 1000000.0);
+        timer->nextSample = (timer->nextSample + 1) % GPU_TIMER_SAMPLE_COUNT;
+        if (timer->sampleCount < GPU_TIMER_SAMPLE_COUNT)
+            timer->sampleCount++;
+        collected = 1;
+    }
+
+    if (collected)
+        UpdateGpuTimerStatistics(timer);
+}
+
+// starts measuring the GPU time of a pass if a query of its ring is free
+static void BeginGpuTimer(BLUfxGpuTimer *timer)
+{
+    if (gpuTimerSupported == -1)
+    {
+        getQueryObjectui64v = GetGLVersion() >= 33 || IsGLExtensionSupported("GL_ARB_timer_query") ? (GetQueryObjectui64vProc) GetGLProcAddress("glGetQueryObjectui64v") : NULL;
+        gpuTimerSupported = getQueryObjectui64v != NULL;
+    }
+
+    timer->active = 0;
+    if (!gpuTimerSupported)
+        return;
+
+    if (timer->queries[0] == 0)
+        glGenQueries(GPU_TIMER_QUERY_COUNT, timer->queries);
+
+    CollectGpuTimer(timer);
+
+    if (timer->pending[timer->nextQuery])
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED, timer->queries[timer->nextQuery]);
+    timer->active = 1;
+}
+
+// stops measuring the GPU time of a pass
+static void EndGpuTimer(BLUfxGpuTimer *timer)
+{
+    if (!timer->active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    timer->pending[timer->nextQuery] = 1;
+    timer->nextQuery = (timer->nextQuery + 1) % GPU_TIMER_QUERY_COUNT;
+    timer->active = 0;
+}
+
+// deletes the queries of all timers and discards their samples
+static void CleanupGpuTimers(void)
+{
+    for (int i = 0; i < GPU_TIMER_MAX; i++)
+    {
+        if (gpuTimers[i].queries[0] != 0)
+            glDeleteQueries(GPU_TIMER_QUERY_COUNT, gpuTimers[i].queries);
+
+        memset(&gpuTimers[i], 0, sizeof(BLUfxGpuTimer));
+    }
+}
+
+// attaches a texture to a framebuffer object, returns 0 if the framebuffer is incomplete
+static int AttachFramebuffer(GLuint *framebuffer, GLuint texture)
+{
+    if (*framebuffer == 0)
+        glGenFramebuffers(1, framebuffer);
+
+    GLint drawFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, *framebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+    return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+// copies the read framebuffer of size x by y into the bound scene texture of size width by height
+static void CopyScene(int path, int x, int y, int width, int height)
+{
+    if (path == SCENE_COPY_PATH_BLIT_FRAMEBUFFER)
+    {
+        GLint drawFramebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+        GLboolean scissorTestEnabled = glIsEnabled(GL_SCISSOR_TEST);
+        if (scissorTestEnabled)
+            glDisable(GL_SCISSOR_TEST);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, sceneFramebuffer);
+        glBlitFramebuffer(0, 0, x, y, 0, 0, width, height, GL_COLOR_BUFFER_BIT, width == x && height == y ? GL_NEAREST : GL_LINEAR);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+        if (scissorTestEnabled)
+            glEnable(GL_SCISSOR_TEST);
+    }
+    else
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, x, y);
+}
+
+// times all scene copy paths supported by the current OpenGL context and returns the fastest one
+static int ProbeSceneCopyPath(int x, int y)
+{
+    int blitSupported = (GetGLVersion() >= 30 || IsGLExtensionSupported("GL_ARB_framebuffer_object")) && AttachFramebuffer(&sceneFramebuffer, textureId);
+    if (!blitSupported)
+    {
+        XPLMDebugString(NAME": Framebuffer blitting is not supported, falling back to glCopyTexSubImage2D for copying the scene\n");
+
+        return SCENE_COPY_PATH_COPY_TEX_SUB_IMAGE;
+    }
+
+    int fastestPath = SCENE_COPY_PATH_COPY_TEX_SUB_IMAGE;
+    double fastestTime = 0.0;
+    for (int path = 0; path < SCENE_COPY_PATH_MAX; path++)
+    {
+        glFinish();
+        double startTime = GetMonotonicTime();
+
+        for (int i = 0; i < SCENE_COPY_PROBE_ITERATIONS; i++)
+            CopyScene(path, x, y, x, y);
+
+        glFinish();
+        double time = (GetMonotonicTime() - startTime) / SCENE_COPY_PROBE_ITERATIONS;
+
+        char message[128];
+        sprintf(message, NAME": Copying the scene with %s takes %.3f ms\n", sceneCopyPathNames[path], time * 1000.0);
+        XPLMDebugString(message);
+
+        if (path == 0 || time < fastestTime)
+        {
+            fastestPath = path;
+            fastestTime = time;
+        }
+    }
+
+    char message[128];
+    sprintf(message, NAME": Using %s for copying the scene\n", sceneCopyPathNames[fastestPath]);
+    XPLMDebugString(message);
+
+    return fastestPath;
+}
+
+// resolves the locations of all uniforms of a freshly linked shader-program and marks all of its uniform values for upload
+static void BindUniformLocations(BLUfxShaderProgram *shaderProgram)
+{
+    for (int i = 0; i < UNIFORM_MAX; i++)
+        shaderProgram->uniformLocations[i] = glGetUniformLocation(shaderProgram->program, uniformNames[i]);
+
+    shaderProgram->uniformsDirty = 1;
+}
+
+// uploads only those uniform values that changed since the last upload, the shader-program must be in use
+static void UploadUniforms(BLUfxShaderProgram *shaderProgram, const BLUfxPreset *parameters, const float *rect)
+{
+    const float *values = (const float *) parameters;
+    float *uploadedValues = (float *) &shaderProgram->uploadedParameters;
+
+    for (int i = 0; i < PARAMETER_MAX; i++)
+    {
+        if (shaderProgram->uniformsDirty || values[i] != uploadedValues[i])
+        {
+            glUniform1f(shaderProgram->uniformLocations[i], values[i]);
+            uploadedValues[i] = values[i];
+        }
+    }
+
+    if (shaderProgram->uniformsDirty)
+    {
+        glUniform1i(shaderProgram->uniformLocations[UNIFORM_SCENE], 0);
+        glUniform1i(shaderProgram->uniformLocations[UNIFORM_VIGNETTE_MASK], 2);
+        glUniform1i(shaderProgram->uniformLocations[UNIFORM_LUT], 1);
+        glUniform1f(shaderProgram->uniformLocations[UNIFORM_LUT_SIZE], (float) lutTextureSize);
+    }
+
+    if (shaderProgram->uniformsDirty || memcmp(rect, shaderProgram->uploadedRect, sizeof(shaderProgram->uploadedRect)) != 0)
+    {
+        glUniform4fv(shaderProgram->uniformLocations[UNIFORM_RECT], 1, rect);
+        memcpy(shaderProgram->uploadedRect, rect, sizeof(shaderProgram->uploadedRect));
+    }
+
+    shaderProgram->uniformsDirty = 0;
+}
+
+// checks once if the driver supports program binaries and resolves their entry points
+static int IsProgramBinarySupported(void)
+{
+    if (programBinarySupported == -1)
+    {
+        programBinarySupported = 0;
+
+        if (GetGLVersion() >= 41 || IsGLExtensionSupported("GL_ARB_get_program_binary"))
+        {
+            getProgramBinary = (GetProgramBinaryProc) GetGLProcAddress("glGetProgramBinary");
+            programBinary = (ProgramBinaryProc) GetGLProcAddress("glProgramBinary");
+            programParameteri = (ProgramParameteriProc) GetGLProcAddress("glProgramParameteri");
+
+            // a driver may support the extension without offering a single binary format
+            GLint formatCount = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+            programBinarySupported = getProgramBinary != NULL && programBinary != NULL && programParameteri != NULL && formatCount > 0;
+        }
+
+        XPLMDebugString(programBinarySupported ? NAME": Program binary cache enabled\n" : NAME": Program binaries are not supported, the program binary cache is disabled\n");
+    }
+
+    return programBinarySupported;
+}
+
+// hashes a string into a running 64-bit FNV-1a hash
+static unsigned long long HashString(unsigned long long hash, const char *string)
+{
+    if (string == NULL)
+        return hash;
+
+    for (const unsigned char *c = (const unsigned char *) string; *c != '\0'; c++)
+    {
+        hash ^= *c;
+        hash *= 0x100000001B3ULL;
+    }
+
+    // terminate every string so that different splits hash differently
+    hash ^= 0xFF;
+    hash *= 0x100000001B3ULL;
+
+    return hash;
+}
+
+// builds the path of the program binary cache file of a shader source and the driver
+static std::string GetProgramCacheFilePath(const char *header)
+{
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    hash = HashString(hash, header);
+    hash = HashString(hash, VERTEX_SHADER);
+    hash = HashString(hash, FRAGMENT_SHADER);
+    hash = HashString(hash, (const char *) glGetString(GL_VENDOR));
+    hash = HashString(hash, (const char *) glGetString(GL_RENDERER));
+    hash = HashString(hash, (const char *) glGetString(GL_VERSION));
+
+    char fileName[32];
+    sprintf(fileName, "%016llx.bin", hash);
+
+    return std::string(PROGRAM_CACHE_PATH) + fileName;
+}
+
+// restores a linked shader-program from the program binary cache, returns 0 on failure
+static int LoadProgramBinary(BLUfxShaderProgram *shaderProgram, const std::string &path)
+{
+    std::ifstream file(path.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!file.is_open())
+        return 0;
+
+    unsigned int magic = 0;
+    GLenum binaryFormat = 0;
+    GLsizei length = 0;
+    file.read((char *) &magic, sizeof(magic));
+    file.read((char *) &binaryFormat, sizeof(binaryFormat));
+    file.read((char *) &length, sizeof(length));
+    if (!file.good() || magic != PROGRAM_CACHE_MAGIC || length <= 0)
+        return 0;
+
+    // reject lengths beyond the end of the file
+    std::streampos binaryStart = file.tellg();
+    file.seekg(0, std::ios_base::end);
+    std::streamoff remaining = file.tellg() - binaryStart;
+    file.seekg(binaryStart);
+    if (!file.good() || length > remaining)
+        return 0;
+
+    char *binary = new char[length];
+    file.read(binary, length);
+    int complete = file.good();
+    file.close();
+
+    // log and clear a pending error, so only the error of glProgramBinary is consumed below
+    GLint isProgramLinked = GL_FALSE;
+    if (complete)
+    {
+        GLenum pendingError = glGetError();
+        if (pendingError != GL_NO_ERROR)
+        {
+            char message[64];
+            sprintf(message, NAME": Found pending OpenGL error 0x%04X\n", pendingError);
+            XPLMDebugString(message);
+        }
+
+        programBinary(shaderProgram->program, binaryFormat, binary, length);
+        glGetError();
+
+        glGetProgramiv(shaderProgram->program, GL_LINK_STATUS, &isProgramLinked);
+    }
+    delete[] binary;
+
+    if (isProgramLinked == GL_FALSE)
+        XPLMDebugString(NAME": The driver rejected a cached program binary, compiling the shader from source\n");
+
+    return isProgramLinked == GL_TRUE;
+}
+
+// stores a linked shader-program in the program binary cache
+static void SaveProgramBinary(BLUfxShaderProgram *shaderProgram, const std::string &path)
+{
+    GLint length = 0;
+    glGetProgramiv(shaderProgram->program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    char *binary = new char[length];
+    GLenum binaryFormat = 0;
+    GLsizei writtenLength = 0;
+    getProgramBinary(shaderProgram->program, length, &writtenLength, &binaryFormat, binary);
+
+#if IBM
+    _mkdir(PROGRAM_CACHE_PATH);
+#else
+    mkdir(PROGRAM_CACHE_PATH, 0755);
+#endif
+
+    std::ofstream file(path.c_str(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    if (writtenLength > 0 && file.is_open())
+    {
+        unsigned int magic = PROGRAM_CACHE_MAGIC;
+        file.write((const char *) &magic, sizeof(magic));
+        file.write((const char *) &binaryFormat, sizeof(binaryFormat));
+        file.write((const char *) &writtenLength, sizeof(writtenLength));
+        file.write(binary, writtenLength);
+    }
+    delete[] binary;
+}
+
+// removes the shaders from video memory, if deleteProgram is set the shader-program is also removed
+static void CleanupShader(BLUfxShaderProgram *shaderProgram, GLuint vertexShader, GLuint fragmentShader, int deleteProgram = 0)
+{
+    if (vertexShader != 0)
+    {
+        glDetachShader(shaderProgram->program, vertexShader);
+        glDeleteShader(vertexShader);
+    }
+
+    if (fragmentShader != 0)
+    {
+        glDetachShader(shaderProgram->program, fragmentShader);
+        glDeleteShader(fragmentShader);
+    }
+
+    if (deleteProgram && shaderProgram->program != 0)
+    {
+        glDeleteProgram(shaderProgram->program);
+        shaderProgram->program = 0;
+    }
+}
+
+// function to load, compile and link the shaders, the header string is placed in front of both shader sources, returns 1 if the program was restored from the program binary cache
+static int InitShader(BLUfxShaderProgram *shaderProgram, const char *header)
+{
+    shaderProgram->program = glCreateProgram();
+
+    std::string cacheFilePath;
+    if (IsProgramBinarySupported())
+    {
+        cacheFilePath = GetProgramCacheFilePath(header);
+        if (LoadProgramBinary(shaderProgram, cacheFilePath))
+        {
+            BindUniformLocations(shaderProgram);
+            return 1;
+        }
+
+        // do not reuse a program object on which glProgramBinary failed
+        glDeleteProgram(shaderProgram->program);
+        shaderProgram->program = glCreateProgram();
+        programParameteri(shaderProgram->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    const char *vertexShaderStrings[2] = {header, VERTEX_SHADER};
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 2, vertexShaderStrings, 0);
+    glCompileShader(vertexShader);
+    glAttachShader(shaderProgram->program, vertexShader);
+    GLint isVertexShaderCompiled = GL_FALSE;
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &isVertexShaderCompiled);
+    if (isVertexShaderCompiled == GL_FALSE)
+    {
+        GLsizei maxLength = 2048;
+        GLchar *log = new GLchar[maxLength];
+        glGetShaderInfoLog(vertexShader, maxLength, &maxLength, log);
+        XPLMDebugString(NAME": The following error occured while compiling the vertex shader:\n");
+        XPLMDebugString(log);
+        delete[] log;
+
+        CleanupShader(shaderProgram, vertexShader, 0, 1);
+
+        return 0;
+    }
+
+    const char *fragmentShaderStrings[2] = {header, FRAGMENT_SHADER};
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 2, fragmentShaderStrings, 0);
+    glCompileShader(fragmentShader);
+    glAttachShader(shaderProgram->program, fragmentShader);
+    GLint isFragmentShaderCompiled = GL_FALSE;
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &isFragmentShaderCompiled);
+    if (isFragmentShaderCompiled == GL_FALSE)
+    {
+        GLsizei maxLength = 2048;
+        GLchar *log = new GLchar[maxLength];
+        glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, log);
+        XPLMDebugString(NAME": The following error occured while compiling the fragment shader:\n");
+        XPLMDebugString(log);
+        delete[] log;
+
+        CleanupShader(shaderProgram, vertexShader, fragmentShader, 1);
+
+        return 0;
+    }
+
+    glBindAttribLocation(shaderProgram->program, 0, "position");
+    glLinkProgram(shaderProgram->program);
+    GLint isProgramLinked = GL_FALSE;
+    glGetProgramiv(shaderProgram->program, GL_LINK_STATUS, &isProgramLinked);
+    if (isProgramLinked == GL_FALSE)
+    {
+        GLsizei maxLength = 2048;
+        GLchar *log = new GLchar[maxLength];
+        glGetProgramInfoLog(shaderProgram->program, maxLength, &maxLength, log);
+        XPLMDebugString(NAME": The following error occured while linking the shader program:\n");
+        XPLMDebugString(log);
+        delete[] log;
+
+        CleanupShader(shaderProgram, vertexShader, fragmentShader, 1);
+
+        return 0;
+    }
+
+    CleanupShader(shaderProgram, vertexShader, fragmentShader);
+
+    if (!cacheFilePath.empty())
+        SaveProgramBinary(shaderProgram, cacheFilePath);
+
+    BindUniformLocations(shaderProgram);
+
+    return 0;
+}
+
+// returns the shader permutation that renders the given parameters with the fewest stages
+static int GetShaderPermutation(const BLUfxPreset *parameters, int reduced = 0)
+{
+    int permutation = 0;
+
+    if (parameters->contrast != 1.0f || parameters->brightness != 0.0f)
+        permutation |= SHADER_FEATURE_CONTRAST_BRIGHTNESS;
+    if (parameters->saturation != 1.0f)
+        permutation |= SHADER_FEATURE_SATURATION;
+    if (parameters->redScale != 0.0f || parameters->greenScale != 0.0f || parameters->blueScale != 0.0f || parameters->redOffset != 0.0f || parameters->greenOffset != 0.0f || parameters->blueOffset != 0.0f)
+        permutation |= SHADER_FEATURE_S_CURVE;
+
+    // the lookup table is skipped while a preset transition runs
+    if ((lutEnabled || reduced) && permutation != 0 && !presetTransition.active)
+        permutation = SHADER_FEATURE_LUT;
+
+    if (parameters->vignette != 0.0f && !reduced)
+        permutation |= SHADER_FEATURE_VIGNETTE;
+
+    return permutation;
+}
+
+// returns the shader-program of a permutation from the cache, it is compiled and linked when it is requested for the first time
+static BLUfxShaderProgram *GetShaderProgram(int permutation)
+{
+    BLUfxShaderProgram *shaderProgram = &shaderPrograms[permutation];
+
+    if (!shaderProgram->initialized)
+    {
+        BLUfxTraceScope traceScope("InitShader", "shader");
+
+        char header[256] = "#version 120\n";
+        for (int i = 0; (1 << i) < SHADER_PERMUTATION_MAX; i++)
+            sprintf(header + strlen(header), "#define %s %d\n", shaderFeatureDefines[i], (permutation >> i) & 1);
+
+        double startTime = GetMonotonicTime();
+        int cached = InitShader(shaderProgram, header);
+        shaderProgram->initialized = 1;
+
+        char message[128];
+        sprintf(message, NAME": %s shader permutation %d in %.2f ms\n", cached ? "Loaded cached" : "Compiled", permutation, (GetMonotonicTime() - startTime) * 1000.0);
+        XPLMDebugString(message);
+    }
+
+    return shaderProgram;
+}
+
+// checks if two parameter sets differ in any parameter that is baked into the color lookup table
+static int ColorGradingChanged(const BLUfxPreset *a, const BLUfxPreset *b)
+{
+    const float *valuesA = (const float *) a;
+    const float *valuesB = (const float *) b;
+
+    for (int i = 0; i < PARAMETER_MAX; i++)
+    {
+        if (i != PARAMETER_VIGNETTE && valuesA[i] != valuesB[i])
+            return 1;
+    }
+
+    return 0;
+}
+
+// bakes the color-grading of the current parameters into the 3D lookup texture, the texture is (re)allocated if its size changed
+static void UpdateLut(void)
+{
+    BLUfxTraceScope traceScope("UpdateLut", "gl");
+
+    int size = lutSize < MIN_LUT_SIZE ? MIN_LUT_SIZE : (lutSize > MAX_LUT_SIZE ? MAX_LUT_SIZE : lutSize);
+
+    GLushort *data = new GLushort[size * size * size * 4];
+    BuildLut(&parameters, size, data);
+
+    glActiveTexture(GL_TEXTURE0 + 1);
+    if (lutTextureId == 0 || lutTextureSize != size)
+    {
+        if (lutTextureId == 0)
+            XPLMGenerateTextureNumbers((int *) &lutTextureId, 1);
+
+        glBindTexture(GL_TEXTURE_3D, lutTextureId);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16, size, size, size, 0, GL_RGBA, GL_UNSIGNED_SHORT, data);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        lutTextureSize = size;
+        for (int i = 0; i < SHADER_PERMUTATION_MAX; i++)
+        {
+            if (i & SHADER_FEATURE_LUT)
+                shaderPrograms[i].uniformsDirty = 1;
+        }
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_3D, lutTextureId);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RGBA, GL_UNSIGNED_SHORT, data);
+    }
+    glActiveTexture(GL_TEXTURE0 + 0);
+
+    delete[] data;
+
+    lutParameters = parameters;
+}
+
+// regenerates the vignette mask texture if the screen size or the vignette shape changed
+static void UpdateVignetteMask(int x, int y)
+{
+    int width = x / VIGNETTE_MASK_DOWNSCALE > 0 ? x / VIGNETTE_MASK_DOWNSCALE : 1;
+    int height = y / VIGNETTE_MASK_DOWNSCALE > 0 ? y / VIGNETTE_MASK_DOWNSCALE : 1;
+    const float shape[4] = {vignetteCenterX, vignetteCenterY, vignetteRadiusX, vignetteRadiusY};
+
+    if (vignetteMaskTextureId != 0 && vignetteMaskWidth == width && vignetteMaskHeight == height && memcmp(vignetteMaskShape, shape, sizeof(shape)) == 0)
+        return;
+
+    BLUfxTraceScope traceScope("UpdateVignetteMask", "gl");
+
+    float radiusX = vignetteRadiusX > MIN_VIGNETTE_RADIUS ? vignetteRadiusX : MIN_VIGNETTE_RADIUS;
+    float radiusY = vignetteRadiusY > MIN_VIGNETTE_RADIUS ? vignetteRadiusY : MIN_VIGNETTE_RADIUS;
+
+    GLubyte *data = new GLubyte[width * height];
+    for (int row = 0; row < height; row++)
+    {
+        float v = ((row + 0.5f) / height - vignetteCenterY) / radiusY;
+        for (int column = 0; column < width; column++)
+        {
+            float u = ((column + 0.5f) / width - vignetteCenterX) / radiusX;
+            data[row * width + column] = (GLubyte) (GetVignetteFactor(u, v) * 255.0f + 0.5f);
+        }
+    }
+
+    if (vignetteMaskTextureId == 0)
+        XPLMGenerateTextureNumbers((int *) &vignetteMaskTextureId, 1);
+
+    glActiveTexture(GL_TEXTURE0 + 2);
+    glBindTexture(GL_TEXTURE_2D, vignetteMaskTextureId);
+    // rows of the single channel mask are tightly packed
+    GLint unpackAlignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0 + 0);
+
+    delete[] data;
+
+    vignetteMaskWidth = width;
+    vignetteMaskHeight = height;
+    memcpy(vignetteMaskShape, shape, sizeof(shape));
+}
+
+// draws a shader-program over the part of the bound width by height framebuffer given by rect
+static void DrawFullScreen(BLUfxShaderProgram *shaderProgram, const BLUfxPreset *parameters, const float *rect, int width, int height)
+{
+    if (vertexArrayObjectSupported == -1)
+    {
+        bindVertexArray = GetGLVersion() >= 30 || IsGLExtensionSupported("GL_ARB_vertex_array_object") ? (BindVertexArrayProc) GetGLProcAddress("glBindVertexArray") : NULL;
+        vertexArrayObjectSupported = bindVertexArray != NULL;
+    }
+
+    GLint viewport[4], arrayBuffer = 0, vertexArray = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+
+    // X-Plane may leave a vertex array object bound, the quad is drawn with the default one so the attribute setup below does not end up in it
+    if (vertexArrayObjectSupported)
+    {
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+        bindVertexArray(0);
+    }
+
+    // attribute 0 is shared with whatever X-Plane draws next, so its complete state is restored afterwards
+    GLint attributeEnabled = 0, attributeSize = 4, attributeType = GL_FLOAT, attributeNormalized = GL_FALSE, attributeStride = 0, attributeBuffer = 0;
+    GLvoid *attributePointer = NULL;
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &attributeEnabled);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attributeSize);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_TYPE, &attributeType);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attributeNormalized);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &attributeStride);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &attributeBuffer);
+    glGetVertexAttribPointerv(0, GL_VERTEX_ATTRIB_ARRAY_POINTER, &attributePointer);
+
+    if (quadVertexBuffer == 0)
+    {
+        static const GLfloat quadVertices[] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+        glGenBuffers(1, &quadVertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    }
+    else
+        glBindBuffer(GL_ARRAY_BUFFER, quadVertexBuffer);
+
+    glUseProgram(shaderProgram->program);
+    UploadUniforms(shaderProgram, parameters, rect);
+
+    glViewport(0, 0, width, height);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindBuffer(GL_ARRAY_BUFFER, attributeBuffer);
+    glVertexAttribPointer(0, attributeSize, attributeType, attributeNormalized, attributeStride, attributePointer);
+    if (attributeEnabled)
+        glEnableVertexAttribArray(0);
+    else
+        glDisableVertexAttribArray(0);
+
+    if (vertexArrayObjectSupported)
+        bindVertexArray(vertexArray);
+
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// frees every OpenGL resource owned by the plugin, the draw-callback recreates them on demand when it runs the next time
+static void CleanupGLResources(void)
+{
+    for (int i = 0; i < SHADER_PERMUTATION_MAX; i++)
+    {
+        CleanupShader(&shaderPrograms[i], 0, 0, 1);
+        shaderPrograms[i].initialized = 0;
+    }
+
+    if (sceneFramebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &sceneFramebuffer);
+        sceneFramebuffer = 0;
+    }
+
+    if (processedFramebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &processedFramebuffer);
+        processedFramebuffer = 0;
+    }
+
+    CleanupRenderTargets();
+    textureId = 0;
+    processedTextureId = 0;
+
+    if (quadVertexBuffer != 0)
+    {
+        glDeleteBuffers(1, &quadVertexBuffer);
+        quadVertexBuffer = 0;
+    }
+
+    CleanupGpuTimers();
+
+    if (lutTextureId != 0)
+    {
+        glDeleteTextures(1, &lutTextureId);
+        lutTextureId = 0;
+    }
+
+    if (vignetteMaskTextureId != 0)
+    {
+        glDeleteTextures(1, &vignetteMaskTextureId);
+        vignetteMaskTextureId = 0;
+    }
+}
+
+// draw-callback that adds post-processing
+static int PostProcessingCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
+{
+    if (!postProcesssingEnabled)
+        return 1;
+
+    BLUfxScopeTimer scopeTimer(CALLBACK_POST_PROCESSING);
+
+    // with identity parameters the post-processed frame would look exactly like the original one, so the copy and the draw are skipped entirely
+    int permutation = GetShaderPermutation(&parameters, qualityTier >= QUALITY_TIER_REDUCED);
+    if (permutation == 0)
+    {
+        bypassedFrames++;
+        return 1;
+    }
+
+    if (qualityTier == QUALITY_TIER_BYPASS)
+    {
+        governorSkippedFrames++;
+        return 1;
+    }
+
+    int x, y;
+    XPLMGetScreenSize(&x, &y);
+
+    // half resolution needs the scaling copy of the blit path
+    int halfResolution = qualityTier >= QUALITY_TIER_HALF_RESOLUTION && sceneCopyPath == SCENE_COPY_PATH_BLIT_FRAMEBUFFER;
+    int width = halfResolution && x > 1 ? x / 2 : x;
+    int height = halfResolution && y > 1 ? y / 2 : y;
+
+    if (!halfResolution && processedTextureId != 0)
+    {
+        ReleaseRenderTarget(processedTextureId);
+        processedTextureId = 0;
+    }
+
+    if(textureId == 0 || lastResolutionX != width || lastResolutionY != height)
+    {
+        glActiveTexture(GL_TEXTURE0 + 0);
+        ReleaseRenderTarget(textureId);
+        textureId = AcquireRenderTarget(width, height, GL_RGBA8);
+        if (textureId == 0)
+            return 1;
+
+        if (sceneCopyPath == SCENE_COPY_PATH_UNKNOWN)
+            sceneCopyPath = ProbeSceneCopyPath(x, y);
+        else if (sceneCopyPath == SCENE_COPY_PATH_BLIT_FRAMEBUFFER && !AttachFramebuffer(&sceneFramebuffer, textureId))
+            sceneCopyPath = SCENE_COPY_PATH_COPY_TEX_SUB_IMAGE;
+
+        lastResolutionX = width;
+        lastResolutionY = height;
+    }
+    else
+    {
+        glActiveTexture(GL_TEXTURE0 + 0);
+        glBindTexture(GL_TEXTURE_2D, textureId);
+    }
+
+    // the scene copy path may just have fallen back to one that cannot scale
+    if (halfResolution && sceneCopyPath != SCENE_COPY_PATH_BLIT_FRAMEBUFFER)
+        return 1;
+
+    if (halfResolution && (processedTextureId == 0 || processedWidth != width || processedHeight != height))
+    {
+        ReleaseRenderTarget(processedTextureId);
+        processedTextureId = AcquireRenderTarget(width, height, GL_RGBA8);
+        if (processedTextureId == 0)
+            return 1;
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        AttachFramebuffer(&processedFramebuffer, processedTextureId);
+
+        processedWidth = width;
+        processedHeight = height;
+
+        glBindTexture(GL_TEXTURE_2D, textureId);
+    }
+
+    BeginGpuTimer(&gpuTimers[GPU_TIMER_COPY]);
+    CopyScene(sceneCopyPath, x, y, width, height);
+    EndGpuTimer(&gpuTimers[GPU_TIMER_COPY]);
+    XPLMSetGraphicsState(0, 1, 0, 0, 0,  0, 0);
+
+    BLUfxShaderProgram *activeShaderProgram = GetShaderProgram(permutation);
+
+    if (permutation & SHADER_FEATURE_LUT)
+    {
+        if (lutTextureId == 0 || ColorGradingChanged(&parameters, &lutParameters))
+            UpdateLut();
+
+        glActiveTexture(GL_TEXTURE0 + 1);
+        glBindTexture(GL_TEXTURE_3D, lutTextureId);
+    }
+
+    if (permutation & SHADER_FEATURE_VIGNETTE)
+    {
+        UpdateVignetteMask(x, y);
+
+        glActiveTexture(GL_TEXTURE0 + 2);
+        glBindTexture(GL_TEXTURE_2D, vignetteMaskTextureId);
+    }
+    glActiveTexture(GL_TEXTURE0 + 0);
+
+    // while the settings window is open only the right half of the screen is post-processed, so the effect can be compared with the original
+    float rect[4] = {!XPIsWidgetVisible(settingsWidget) ? 0.0f : 0.5f, 0.0f, 1.0f, 1.0f};
+
+    if (activeShaderProgram->program != 0)
+    {
+        BeginGpuTimer(&gpuTimers[GPU_TIMER_SHADE]);
+
+        if (halfResolution)
+        {
+            // render into the half resolution target and stretch it over the screen
+            BLUfxShaderProgram *upscaleShaderProgram = GetShaderProgram(0);
+            const float fullRect[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+
+            GLint drawFramebuffer = 0;
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+            GLboolean scissorTestEnabled = glIsEnabled(GL_SCISSOR_TEST);
+            if (scissorTestEnabled)
+                glDisable(GL_SCISSOR_TEST);
+
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, processedFramebuffer);
+            DrawFullScreen(activeShaderProgram, &parameters, fullRect, width, height);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+
+            if (scissorTestEnabled)
+                glEnable(GL_SCISSOR_TEST);
+
+            if (upscaleShaderProgram->program != 0)
+            {
+                glBindTexture(GL_TEXTURE_2D, processedTextureId);
+                DrawFullScreen(upscaleShaderProgram, &parameters, rect, x, y);
+            }
+        }
+        else
+            DrawFullScreen(activeShaderProgram, &parameters, rect, x, y);
+
+        EndGpuTimer(&gpuTimers[GPU_TIMER_SHADE]);
+    }
+
+    if (permutation & SHADER_FEATURE_LUT)
+    {
+        glActiveTexture(GL_TEXTURE0 + 1);
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+    if (permutation & SHADER_FEATURE_VIGNETTE)
+    {
+        glActiveTexture(GL_TEXTURE0 + 2);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0 + 0);
+
+    return 1;
+}
+
+// returns the handle of a cached sim DataRef, DataRefs that do not exist yet (like private ones) are looked up again on every access
+static XPLMDataRef GetSimDataRef(BLUfxCachedDataRef *cachedDataRef)
+{
+    if (cachedDataRef->dataRef == NULL)
+        cachedDataRef->dataRef = XPLMFindDataRef(cachedDataRef->name);
+
+    return cachedDataRef->dataRef;
+}
+
+// makes sure the cached value of a sim DataRef is from the current frame, a pending write is the most recent value and needs no read
+static void ReadCachedDataRef(BLUfxCachedDataRef *cachedDataRef)
+{
+    if (cachedDataRef->readFrame == dataRefCacheFrame || cachedDataRef->dirty)
+    {
+        dataRefCacheCounters[DATAREF_CACHE_READS_SAVED]++;
+        return;
+    }
+
+    if (GetSimDataRef(cachedDataRef) == NULL)
+        return;
+
+    if (cachedDataRef->type == xplmType_Int)
+        cachedDataRef->intValue = XPLMGetDatai(cachedDataRef->dataRef);
+    else
+        cachedDataRef->floatValue = XPLMGetDataf(cachedDataRef->dataRef);
+    cachedDataRef->valueKnown = 1;
+    cachedDataRef->readFrame = dataRefCacheFrame;
+}
+
+// returns the value of an int sim DataRef, it is read at most once per frame
+static int GetCachedDatai(int simDataRef)
+{
+    ReadCachedDataRef(&cachedDataRefs[simDataRef]);
+
+    return cachedDataRefs[simDataRef].intValue;
+}
+
+// queues a write of an int sim DataRef for the end of the frame, writes of the last known value are dropped and several writes in one frame are coalesced
+static void SetCachedDatai(int simDataRef, int value)
+{
+    BLUfxCachedDataRef *cachedDataRef = &cachedDataRefs[simDataRef];
+    int unchanged = cachedDataRef->valueKnown && cachedDataRef->intValue == value;
+
+    if (unchanged || cachedDataRef->dirty)
+        dataRefCacheCounters[DATAREF_CACHE_WRITES_SAVED]++;
+
+    if (!unchanged)
+    {
+        cachedDataRef->intValue = value;
+        cachedDataRef->valueKnown = 1;
+        cachedDataRef->dirty = 1;
+    }
+}
+
+// queues a write of a float sim DataRef for the end of the frame, writes of the last known value are dropped and several writes in one frame are coalesced
+static void SetCachedDataf(int simDataRef, float value)
+{
+    BLUfxCachedDataRef *cachedDataRef = &cachedDataRefs[simDataRef];
+    int unchanged = cachedDataRef->valueKnown && cachedDataRef->floatValue == value;
+
+    if (unchanged || cachedDataRef->dirty)
+        dataRefCacheCounters[DATAREF_CACHE_WRITES_SAVED]++;
+
+    if (!unchanged)
+    {
+        cachedDataRef->floatValue = value;
+        cachedDataRef->valueKnown = 1;
+        cachedDataRef->dirty = 1;
+    }
+}
+
+// forgets the value of a sim DataRef, needed when somebody else may have changed it and the next write must not be dropped
+static void InvalidateCachedDataRef(int simDataRef)
+{
+    cachedDataRefs[simDataRef].valueKnown = 0;
+    cachedDataRefs[simDataRef].readFrame = 0;
+}
+
+// writes all pending values to the sim and starts a new cache frame, it is called once at the end of every frame
+static void FlushDataRefCache(void)
+{
+    for (int i = 0; i < SIM_DATAREF_MAX; i++)
+    {
+        BLUfxCachedDataRef *cachedDataRef = &cachedDataRefs[i];
+        if (!cachedDataRef->dirty)
+            continue;
+
+        cachedDataRef->dirty = 0;
+        if (GetSimDataRef(cachedDataRef) == NULL)
+        {
+            cachedDataRef->valueKnown = 0;
+            continue;
+        }
+
+        if (cachedDataRef->type == xplmType_Int)
+            XPLMSetDatai(cachedDataRef->dataRef, cachedDataRef->intValue);
+        else
+            XPLMSetDataf(cachedDataRef->dataRef, cachedDataRef->floatValue);
+    }
+
+    for (int i = 0; i < DATAREF_CACHE_STATISTIC_MAX; i++)
+    {
+        dataRefCacheStatistics[i] = dataRefCacheCounters[i];
+        dataRefCacheCounters[i] = 0;
+    }
+
+    dataRefCacheFrame++;
+}
+
+// orders the schedule of the flightloop dispatcher so that the task that fires first is at the front
+static bool IsTaskDueLater(const BLUfxScheduledTask &a, const BLUfxScheduledTask &b)
+{
+    return a.fireTime > b.fireTime;
+}
+
+// removes a task from the schedule of the flightloop dispatcher, nothing happens if it is not scheduled
+static void CancelTask(int task)
+{
+    for (int i = 0; i < scheduledTaskCount; i++)
+    {
+        if (scheduledTasks[i].task == task)
+        {
+            scheduledTasks[i] = scheduledTasks[--scheduledTaskCount];
+            std::make_heap(scheduledTasks, scheduledTasks + scheduledTaskCount, IsTaskDueLater);
+
+            return;
+        }
+    }
+}
+
+// (re)schedules a task to be run by the flightloop dispatcher after delay seconds, a delay of zero runs it in the next flightloop
+static void ScheduleTask(int task, float delay)
+{
+    CancelTask(task);
+
+    BLUfxScheduledTask scheduledTask = {GetMonotonicTime() + delay, task};
+    scheduledTasks[scheduledTaskCount++] = scheduledTask;
+    std::push_heap(scheduledTasks, scheduledTasks + scheduledTaskCount, IsTaskDueLater);
+
+    // the dispatcher has to wake up earlier if the task is now the first one to fire, while it is dispatching it reschedules itself anyway
+    if (!dispatchingTasks && dispatcherFlightLoop != NULL && scheduledTasks[0].task == task)
+        XPLMScheduleFlightLoop(dispatcherFlightLoop, delay > 0.0f ? delay : -1.0f, 1);
+}
+
+// task that resizes the fake window if the screen size has changed since the last resize
+static float UpdateFakeWindowTask(void)
+{
+    BLUfxScopeTimer scopeTimer(CALLBACK_UPDATE_FAKE_WINDOW);
+
+    if (fakeWindow != NULL)
+    {
+        int x = 0, y = 0;
+        XPLMGetScreenSize(&x, &y);
+
+        if (x != fakeWindowWidth || y != fakeWindowHeight)
+        {
+            XPLMSetWindowGeometry(fakeWindow, 0, y, x, 0);
+            fakeWindowWidth = x;
+            fakeWindowHeight = y;
+        }
+    }
+
+    return FAKE_WINDOW_UPDATE_INTERVAL;
+}
+
+// one-shot task that brings the fake window to the front, it is scheduled again whenever loading a plane may have put other windows in front of it
+static float BringFakeWindowToFrontTask(void)
+{
+    BLUfxScopeTimer scopeTimer(CALLBACK_UPDATE_FAKE_WINDOW);
+
+    if (fakeWindow != NULL)
+        XPLMBringWindowToFront(fakeWindow);
+
+    return -1.0f;
+}
+
+// sleeps until shortly before an absolute deadline on the monotonic clock and spins for the rest of the time, the spin threshold follows the wake-up error of the sleeps
+static void SleepUntil(double deadline)
+{
+    double sleepDeadline = deadline - spinThreshold;
+    double now = GetMonotonicTime();
+
+    if (sleepDeadline > now)
+    {
+#if IBM
+        Sleep((DWORD) ((sleepDeadline - now) * 1000.0));
+#elif LIN
+        struct timespec ts;
+        ts.tv_sec = (time_t) sleepDeadline;
+        ts.tv_nsec = (long) ((sleepDeadline - (double) ts.tv_sec) * 1000000000.0);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+        // macOS has no clock_nanosleep, so the absolute deadline is turned into a relative sleep
+        usleep((useconds_t) ((sleepDeadline - now) * 1000000.0));
+#endif
+
+        // a late wake-up widens the spin threshold, so that the deadline is not missed the next time
+        double wakeUpError = GetMonotonicTime() - sleepDeadline;
+        double difference = wakeUpError - wakeUpErrorMean;
+        wakeUpErrorMean += LIMITER_SMOOTHING * difference;
+        wakeUpErrorDeviation += LIMITER_SMOOTHING * (fabs(difference) - wakeUpErrorDeviation);
+
+        spinThreshold = wakeUpErrorMean + 4.0 * wakeUpErrorDeviation;
+        spinThreshold = spinThreshold < MIN_SPIN_THRESHOLD ? MIN_SPIN_THRESHOLD : (spinThreshold > MAX_SPIN_THRESHOLD ? MAX_SPIN_THRESHOLD : spinThreshold);
+    }
+
+    while (GetMonotonicTime() < deadline)
+    {
+#if IBM
+        Sleep(0);
+#endif
+    }
+}
+
+// holds the thread until the deadline of the current frame to achieve the set maximum frame rate
+static void LimitFps(void)
+{
+    // sleep at most once per frame, whichever hook runs first
+    int cycle = XPLMGetCycleNumber();
+    if (cycle == limiter.lastCycle)
+        return;
+    limiter.lastCycle = cycle;
+
+    double now = GetMonotonicTime();
+    limiter.deadline += 1.0 / maxFps;
+
+    // a frame that already missed its deadline restarts the cadence instead of trying to catch up
+    if (limiter.deadline < now)
+        limiter.deadline = now;
+    else
+    {
+        BLUfxTraceScope traceScope("LimitFps", "limiter");
+        SleepUntil(limiter.deadline);
+        limiter.sleepTime += GetMonotonicTime() - now;
+    }
+
+    now = GetMonotonicTime();
+    if (limiter.lastFrameTime != 0.0)
+    {
+        double frameTime = now - limiter.lastFrameTime;
+        double difference = frameTime - limiter.frameTimeMean;
+        limiter.frameTimeMean += LIMITER_SMOOTHING * difference;
+        limiter.frameTimeVariance = (1.0 - LIMITER_SMOOTHING) * (limiter.frameTimeVariance + LIMITER_SMOOTHING * difference * difference);
+    }
+    limiter.lastFrameTime = now;
+}
+
+// task that limits the number of flightcycles
+static float LimiterFlightTask(void)
+{
+    BLUfxScopeTimer scopeTimer(CALLBACK_LIMITER_FLIGHT);
+
+    LimitFps();
+
+    return 0.0f;
+}
+
+// draw-callback that limits the number of drawcycles
+static int LimiterDrawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
+{
+    if (!fpsLimiterEnabled)
+        return 1;
+
+    BLUfxScopeTimer scopeTimer(CALLBACK_LIMITER_DRAW);
+
+    LimitFps();
+
+    return 1;
+}
+
+// recomputes the frame statistics from the sliding window of frame times, the lows are the frame rates of the 99th and 99.9th percentile frame times
+static void UpdateFrameStatistics(void)
+{
+    if (frameTimeCount == 0)
+        return;
+
+    static float sortedFrameTimes[FRAME_TIME_COUNT];
+    memcpy(sortedFrameTimes, frameTimes, frameTimeCount * sizeof(float));
+
+    double sum = 0.0, squareSum = 0.0;
+    for (int i = 0; i < frameTimeCount; i++)
+    {
+        sum += sortedFrameTimes[i];
+        squareSum += sortedFrameTimes[i] * sortedFrameTimes[i];
+    }
+    double mean = sum / frameTimeCount;
+    double variance = squareSum / frameTimeCount - mean * mean;
+
+    int onePercentIndex = (frameTimeCount * 99) / 100;
+    int pointOnePercentIndex = (frameTimeCount * 999) / 1000;
+    std::nth_element(sortedFrameTimes, sortedFrameTimes + pointOnePercentIndex, sortedFrameTimes + frameTimeCount);
+    float pointOnePercentFrameTime = sortedFrameTimes[pointOnePercentIndex];
+    std::nth_element(sortedFrameTimes, sortedFrameTimes + onePercentIndex, sortedFrameTimes + pointOnePercentIndex);
+    float onePercentFrameTime = sortedFrameTimes[onePercentIndex];
+
+    frameStatistics[FRAME_STATISTIC_AVERAGE_FPS] = mean > 0.0 ? (float) (1000.0 / mean) : 0.0f;
+    frameStatistics[FRAME_STATISTIC_ONE_PERCENT_LOW_FPS] = onePercentFrameTime > 0.0f ? 1000.0f / onePercentFrameTime : 0.0f;
+    frameStatistics[FRAME_STATISTIC_POINT_ONE_PERCENT_LOW_FPS] = pointOnePercentFrameTime > 0.0f ? 1000.0f / pointOnePercentFrameTime : 0.0f;
+    frameStatistics[FRAME_STATISTIC_FRAME_TIME_DEVIATION] = variance > 0.0 ? (float) sqrt(variance) : 0.0f;
+}
+
+// writes the frame times of the sliding window to a CSV file, oldest first
+static void SaveFrameTimes(void)
+{
+    std::fstream file;
+    file.open(FRAME_TIMES_PATH, std::ios_base::out | std::ios_base::trunc);
+
+    if(file.is_open())
+    {
+        file << "frame,frame_time_ms" << std::endl;
+
+        int first = frameTimeCount < FRAME_TIME_COUNT ? 0 : nextFrameTime;
+        for (int i = 0; i < frameTimeCount; i++)
+            file << i << "," << frameTimes[(first + i) % FRAME_TIME_COUNT] << std::endl;
+
+        file.close();
+
+        char message[64];
+        sprintf(message, NAME": Saved %d frame times\n", frameTimeCount);
+        XPLMDebugString(message);
+    }
+}
+
+// switches the post-processing to another quality tier
+static void SetQualityTier(int tier, double now)
+{
+    if (tier > qualityTier)
+    {
+        // a premature upgrade makes the next one wait longer
+        if (now - governorLastUpgradeTime < governorUpgradeDelay)
+            governorUpgradeDelay = std::min(governorUpgradeDelay * 2.0, GOVERNOR_MAX_UPGRADE_DELAY);
+    }
+    else if (tier < qualityTier)
+        governorLastUpgradeTime = now;
+
+    qualityTier = tier;
+    governorLastChangeTime = now;
+    governorOverBudgetTime = 0.0;
+    governorUnderBudgetTime = 0.0;
+
+    char message[64];
+    sprintf(message, NAME": Switched to quality tier '%s'\n", qualityTierNames[tier]);
+    XPLMDebugString(message);
+}
+
+// steps the post-processing through the quality tiers so that the work of a frame fits into the limiter budget
+static void UpdateQualityGovernor(double workTime, double frameTime, double now)
+{
+    if (!qualityGovernorEnabled || !postProcesssingEnabled || !fpsLimiterEnabled)
+    {
+        if (qualityTier != QUALITY_TIER_FULL)
+            SetQualityTier(QUALITY_TIER_FULL, now);
+
+        return;
+    }
+
+    governorLoad += LIMITER_SMOOTHING * (workTime * maxFps - governorLoad);
+
+    if (now - governorLastChangeTime < GOVERNOR_COOLDOWN)
+        return;
+
+    if (governorLoad > GOVERNOR_DOWNGRADE_LOAD)
+    {
+        governorUnderBudgetTime = 0.0;
+        governorOverBudgetTime += frameTime;
+        if (governorOverBudgetTime >= GOVERNOR_DOWNGRADE_DELAY && qualityTier < QUALITY_TIER_BYPASS)
+            SetQualityTier(qualityTier + 1, now);
+    }
+    else if (governorLoad < GOVERNOR_UPGRADE_LOAD)
+    {
+        governorOverBudgetTime = 0.0;
+        governorUnderBudgetTime += frameTime;
+        if (governorUnderBudgetTime >= governorUpgradeDelay && qualityTier > QUALITY_TIER_FULL)
+            SetQualityTier(qualityTier - 1, now);
+    }
+    else
+    {
+        governorOverBudgetTime = 0.0;
+        governorUnderBudgetTime = 0.0;
+
+        // a tier that held for a while resets the upgrade delay
+        if (now - governorLastChangeTime > GOVERNOR_MAX_UPGRADE_DELAY)
+            governorUpgradeDelay = GOVERNOR_MIN_UPGRADE_DELAY;
+    }
+}
+
+// maps the linear progress of a crossfade onto its easing curve
+static float EasePresetTransition(float t)
+{
+    switch (presetTransitionEasing)
+    {
+    case PRESET_TRANSITION_EASING_EASE_IN:
+        return t * t;
+    case PRESET_TRANSITION_EASING_EASE_OUT:
+        return t * (2.0f - t);
+    case PRESET_TRANSITION_EASING_EASE_IN_OUT:
+        return t * t * (3.0f - 2.0f * t);
+    default:
+        return t;
+    }
+}
+
+// starts a crossfade to target, preset is -1 if the target is not a preset
+static void StartPresetTransition(const BLUfxPreset *target, int preset)
+{
+    presetTransition.preset = preset;
+    presetTransition.from = parameters;
+    presetTransition.to = *target;
+    presetTransition.startTime = GetMonotonicTime();
+    presetTransition.duration = presetTransitionTime;
+    presetTransition.progress = 0.0f;
+    presetTransition.active = 1;
+
+    // without a duration the target is applied right away
+    if (presetTransition.duration <= 0.0)
+    {
+        parameters = *target;
+        presetTransition.progress = 1.0f;
+        presetTransition.active = 0;
+    }
+
+    settingsWidgetsStale = 1;
+}
+
+// stops a running crossfade at its current parameters
+static void CancelPresetTransition(void)
+{
+    if (presetTransition.active)
+    {
+        presetTransition.active = 0;
+        presetTransition.progress = 1.0f;
+    }
+}
+
+// advances a running crossfade to the given time
+static void UpdatePresetTransition(double now)
+{
+    if (!presetTransition.active)
+        return;
+
+    float t = (float) ((now - presetTransition.startTime) / presetTransition.duration);
+    if (t >= 1.0f)
+    {
+        t = 1.0f;
+        presetTransition.active = 0;
+    }
+    presetTransition.progress = t;
+
+    float easedT = EasePresetTransition(t);
+    const float *from = (const float *) &presetTransition.from, *to = (const float *) &presetTransition.to;
+    float *values = (float *) &parameters;
+    for (int i = 0; i < PARAMETER_MAX; i++)
+        values[i] = from[i] + (to[i] - from[i]) * easedT;
+
+    // the end of a crossfade hits the target exactly
+    if (!presetTransition.active)
+        parameters = presetTransition.to;
+
+    settingsWidgetsStale = 1;
+}
+
+// applies the parameters received from other plugins at the end of a frame
+static void ApplyPendingParameters(void)
+{
+    if (transitionDepth > 0)
+    {
+        if (++transitionFrames < MAX_TRANSITION_FRAMES)
+            return;
+
+        XPLMDebugString(NAME": A transition was not ended in time, applying the pending parameters\n");
+        transitionDepth = 0;
+    }
+
+    if (!pendingParametersValid)
+        return;
+
+    CancelPresetTransition();
+    parameters = pendingParameters;
+    pendingParametersValid = 0;
+    settingsWidgetsStale = 1;
+}
+
+// task that auto-controls cinema-verite, it only runs again while an input timeout is pending
+static float ControlCinemaVeriteTask(void)
+{
+    BLUfxScopeTimer scopeTimer(CALLBACK_CONTROL_CINEMA_VERITE);
+
+    // while overridden somebody else owns the DataRef, so the value has to be written again once the override ends
+    if (overrideControlCinemaVerite)
+    {
+        lastCinemaVerite = -1;
+        InvalidateCachedDataRef(SIM_DATAREF_CINEMA_VERITE);
+        return -1.0f;
+    }
+
+    lastViewType = GetCachedDatai(SIM_DATAREF_VIEW_TYPE);
+
+    int cinemaVerite = 1;
+    float nextEvaluation = -1.0f;
+    if (lastViewType == VIEW_TYPE_3D_COCKPIT)
+    {
+        float remainingTime = disableCinemaVeriteTime - (XPLMGetElapsedTime() - lastMouseUsageTime);
+
+        // cinema-verite stays disabled until the input timeout expires, which is exactly when the next evaluation is due
+        if (remainingTime >= 0.0f)
+        {
+            cinemaVerite = 0;
+            nextEvaluation = remainingTime;
+        }
+    }
+
+    SetCachedDatai(SIM_DATAREF_CINEMA_VERITE, cinemaVerite);
+    lastCinemaVerite = cinemaVerite;
+
+    return nextEvaluation;
+}
+
+// makes the cinema-verite controller re-evaluate its state in the next flightloop, forced causes the DataRef to be written even if the state did not change
+static void WakeCinemaVeriteController(int forced)
+{
+    if (!controlCinemaVeriteEnabled)
+        return;
+
+    if (forced)
+    {
+        lastCinemaVerite = -1;
+        InvalidateCachedDataRef(SIM_DATAREF_CINEMA_VERITE);
+    }
+
+    ScheduleTask(TASK_CONTROL_CINEMA_VERITE, 0.0f);
+}
+
+// wakes the cinema-verite controller when the view type changed since its last evaluation
+static void CheckViewType(void)
+{
+    if (controlCinemaVeriteEnabled && !overrideControlCinemaVerite && GetCachedDatai(SIM_DATAREF_VIEW_TYPE) != lastViewType)
+        WakeCinemaVeriteController(0);
+}
+
+// draw-callback that records the frame times and draws the frame statistics overlay
+static int FrameStatisticsCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
 {
-    int x, y;
-    XPLMGetScreenSize(&x, &y);
+    BLUfxScopeTimer scopeTimer(CALLBACK_FRAME_STATISTICS);
 
-    if(textureId == 0 || lastResolutionX != x || lastResolutionY != y)
+    double now = GetMonotonicTime();
+    if (lastFrameTime != 0.0)
     {
-        XPLMGenerateTextureNumbers((int *) &textureId, 1);
-        glActiveTexture(GL_TEXTURE0 + 0);
-        glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        double frameTime = now - lastFrameTime;
+        UpdateQualityGovernor(frameTime - limiter.sleepTime, frameTime, now);
 
-        lastResolutionX = x;
-        lastResolutionY = y;
+        frameTimes[nextFrameTime] = (float) (frameTime * 1000.0);
+        nextFrameTime = (nextFrameTime + 1) % FRAME_TIME_COUNT;
+        if (frameTimeCount < FRAME_TIME_COUNT)
+            frameTimeCount++;
     }
-    else
+    lastFrameTime = now;
+    limiter.sleepTime = 0.0;
+
+    if (now - lastFrameStatisticsTime >= FRAME_STATISTICS_INTERVAL)
     {
-        glActiveTexture(GL_TEXTURE0 + 0);
-        glBindTexture(GL_TEXTURE_2D, textureId);
+        UpdateFrameStatistics();
+        lastFrameStatisticsTime = now;
     }
 
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, x, y);
-    XPLMSetGraphicsState(0, 1, 0, 0, 0,  0, 0);
-
-    glUseProgram(program);
+    if (frameStatisticsOverlayEnabled)
+    {
+        int x, y;
+        XPLMGetScreenSize(&x, &y);
 
-    int brightnessLocation = glGetUniformLocation(program, "brightness");
-    glUniform1f(brightnessLocation, brightness);
+        char text[128];
+        sprintf(text, NAME": %.1f fps  1%% low: %.1f  0.1%% low: %.1f  sd: %.2f ms", frameStatistics[FRAME_STATISTIC_AVERAGE_FPS], frameStatistics[FRAME_STATISTIC_ONE_PERCENT_LOW_FPS], frameStatistics[FRAME_STATISTIC_POINT_ONE_PERCENT_LOW_FPS], frameStatistics[FRAME_STATISTIC_FRAME_TIME_DEVIATION]);
 
-    int contrastLocation = glGetUniformLocation(program, "contrast");
-    glUniform1f(contrastLocation, contrast);
+        float color[3] = {1.0f, 1.0f, 1.0f};
+        XPLMDrawString(color, 10, y - 20, text, NULL, xplmFont_Proportional);
+    }
 
-    int saturationLocation = glGetUniformLocation(program, "saturation");
-    glUniform1f(saturationLocation, saturation);
+    CheckViewType();
+    UpdatePresetTransition(now);
+    ApplyPendingParameters();
+    FlushDataRefCache();
 
-    int redScaleLocation = glGetUniformLocation(program, "redScale");
-    glUniform1f(redScaleLocation, redScale);
+    return 1;
+}
 
-    int greenScaleLocation = glGetUniformLocation(program, "greenScale");
-    glUniform1f(greenScaleLocation, greenScale);
+// functions of the tasks run by the flightloop dispatcher, they return the delay in seconds until they want to run again or a negative value if they are done
+static float (*const taskFunctions[TASK_MAX])(void) =
+{
+    UpdateFakeWindowTask,
+    BringFakeWindowToFrontTask,
+    LimiterFlightTask,
+    ControlCinemaVeriteTask
+};
 
-    int blueScaleLocation = glGetUniformLocation(program, "blueScale");
-    glUniform1f(blueScaleLocation, blueScale);
+// flightloop-callback that runs all due tasks and sleeps until the next one fires, so most flightloops cost a single call that does nothing
+static float DispatchTasksCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+{
+    double now = GetMonotonicTime();
 
-    int redOffsetLocation = glGetUniformLocation(program, "redOffset");
-    glUniform1f(redOffsetLocation, redOffset);
+    // the due tasks are taken off the schedule first, so tasks that want to run every flightloop do not run twice in one
+    BLUfxScheduledTask dueTasks[TASK_MAX];
+    int dueTaskCount = 0;
+    while (scheduledTaskCount > 0 && scheduledTasks[0].fireTime <= now)
+    {
+        std::pop_heap(scheduledTasks, scheduledTasks + scheduledTaskCount, IsTaskDueLater);
+        dueTasks[dueTaskCount++] = scheduledTasks[--scheduledTaskCount];
+    }
 
-    int greenOffsetLocation = glGetUniformLocation(program, "greenOffset");
-    glUniform1f(greenOffsetLocation, greenOffset);
+    dispatchingTasks = 1;
+    for (int i = 0; i < dueTaskCount; i++)
+    {
+        float delay = taskFunctions[dueTasks[i].task]();
+        if (delay >= 0.0f)
+            ScheduleTask(dueTasks[i].task, delay);
+    }
+    dispatchingTasks = 0;
 
-    int blueOffsetLocation = glGetUniformLocation(program, "blueOffset");
-    glUniform1f(blueOffsetLocation, blueOffset);
+    if (scheduledTaskCount == 0)
+        return 0.0f;
 
-    int resolutionLocation = glGetUniformLocation(program, "resolution");
-    glUniform2f(resolutionLocation, (float) x, (float) y);
+    float delay = (float) (scheduledTasks[0].fireTime - GetMonotonicTime());
 
-    int vignetteLocation = glGetUniformLocation(program, "vignette");
-    glUniform1f(vignetteLocation, vignette);
+    return delay > 0.0f ? delay : -1.0f;
+}
 
-    int sceneLocation = glGetUniformLocation(program, "scene");
-    glUniform1i(sceneLocation, 0);
+// records mouse input, the cinema-verite controller is only woken up if the input causes a transition
+static void UpdateMouseUsage(void)
+{
+    lastMouseUsageTime = XPLMGetElapsedTime();
 
-    glPushAttrib(GL_VIEWPORT_BIT);
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0.0f, x, 0.0f, y, -1.0f, 1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    glViewport(0, 0, x, y);
+    if (lastViewType == VIEW_TYPE_3D_COCKPIT && lastCinemaVerite != 0 && !overrideControlCinemaVerite)
+        WakeCinemaVeriteController(0);
+}
 
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glBegin(GL_QUADS);
-    int settingsWindowOpen = XPIsWidgetVisible(settingsWidget);
-    glTexCoord2f((!settingsWindowOpen ? 0.0f : 0.5f), 0.0f);
-    glVertex2f((!settingsWindowOpen ? 0.0f : (GLfloat) (x / 2.0f)), 0.0f);
-    glTexCoord2f((!settingsWindowOpen ? 0.0f : 0.5f), 1.0f);
-    glVertex2f((!settingsWindowOpen ? 0.0f : (GLfloat) (x / 2.0f)), (GLfloat) y);
-    glTexCoord2f(1.0f, 1.0f);
-    glVertex2f((GLfloat) x, (GLfloat) y);
-    glTexCoord2f(1.0f, 0.0f);
-    glVertex2f((GLfloat) x, 0.0f);
-    glEnd();
+// get accessor for override_cinema_verite_control DataRef
+int GetOverrideControlCinemaVeriteDataRefCallback(void* inRefcon)
+{
+    return overrideControlCinemaVerite;
+}
 
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-    glPopAttrib();
+// set accessor for override_control_cinema_verite DataRef
+void SetOverrideControlCinemaVeriteDataRefCallback(void* inRefcon, int inValue)
+{
+    overrideControlCinemaVerite = inValue;
 
-    glUseProgram(0);
+    if (!overrideControlCinemaVerite)
+        WakeCinemaVeriteController(1);
+}
 
-    return 1;
+// get accessor for bypassed_frames DataRef
+int GetBypassedFramesDataRefCallback(void* inRefcon)
+{
+    return bypassedFrames;
 }
 
-// flightloop-callback that resizes and brings the fake window back to the front if needed
-static float UpdateFakeWindowCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+// get accessor for render_target_memory DataRef
+int GetRenderTargetMemoryDataRefCallback(void* inRefcon)
 {
-    if (fakeWindow != NULL)
-    {
-        int x = 0, y = 0;
-        XPLMGetScreenSize(&x, &y);
-        XPLMSetWindowGeometry(fakeWindow, 0, y, x, 0);
+    return renderTargetMemory;
+}
 
-        if (!bringFakeWindowToFront)
-        {
-            XPLMBringWindowToFront(fakeWindow);
-            bringFakeWindowToFront = 1;
-        }
-    }
+// get accessor for the perf/gpu_* DataRefs, the refcon points to the published value
+float GetGpuTimerStatisticDataRefCallback(void* inRefcon)
+{
+    return *(float *) inRefcon;
+}
 
-    return -1.0f;
+// get accessor for the perf/cpu_*_calls DataRefs, the refcon points to the histogram of the callback
+int GetCpuTimerCallsDataRefCallback(void* inRefcon)
+{
+    return ((BLUfxHistogram *) inRefcon)->count;
 }
 
-// lets the thread sleep to achieve the set maximum frame rate
-inline static void LimitFps(float dt)
+// get accessor for the perf/cpu_*_avg_ms DataRefs
+float GetCpuTimerAverageDataRefCallback(void* inRefcon)
 {
-    float t = 1.0f / maxFps - dt;
+    BLUfxHistogram *histogram = (BLUfxHistogram *) inRefcon;
 
-    if (t > 0.0f)
-    {
-#if IBM
-        DWORD currentTime = timeGetTime();
-        DWORD targetTime = currentTime + (DWORD) (t * 1000.0f);
-        while (currentTime < targetTime)
-        {
-            Sleep(0);
-            currentTime = timeGetTime();
-        }
-#else
-        usleep((useconds_t)(t * 1000000.0f));
-#endif
-    }
+    return histogram->count > 0 ? (float) (histogram->sum / histogram->count / 1000.0) : 0.0f;
 }
 
-// flightloop-callback that limits the number of flightcycles
-static float LimiterFlightCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+// get accessor for the perf/cpu_*_p50_ms DataRefs
+float GetCpuTimerP50DataRefCallback(void* inRefcon)
 {
-    endTimeFlight = XPLMGetElapsedTime();
-    LimitFps(endTimeFlight - startTimeFlight);
-    startTimeFlight = XPLMGetElapsedTime();
-
-    return -1.0f;
+    return GetHistogramPercentile((BLUfxHistogram *) inRefcon, 0.5f);
 }
 
-// draw-callback that limits the number of drawcycles
-static int LimiterDrawCallback(XPLMDrawingPhase inPhase, int inIsBefore, void *inRefcon)
+// get accessor for the perf/cpu_*_p99_ms DataRefs
+float GetCpuTimerP99DataRefCallback(void* inRefcon)
 {
-    endTimeDraw = XPLMGetElapsedTime();
-    LimitFps(endTimeDraw - startTimeDraw);
-    startTimeDraw = XPLMGetElapsedTime();
+    return GetHistogramPercentile((BLUfxHistogram *) inRefcon, 0.99f);
+}
 
-    return 1;
+// get accessor for the perf/cpu_*_max_ms DataRefs
+float GetCpuTimerMaximumDataRefCallback(void* inRefcon)
+{
+    return (float) (((BLUfxHistogram *) inRefcon)->maximum / 1000.0);
 }
 
-// flightloop-callback that auto-controls cinema-verite
-static float ControlCinemaVeriteCallback(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void *inRefcon)
+// get accessor for the perf/cpu_*_histogram DataRefs
+int GetCpuTimerHistogramDataRefCallback(void* inRefcon, int *outValues, int inOffset, int inMax)
 {
-    if (!overrideControlCinemaVerite)
-    {
-        if (XPLMGetDatai(viewTypeDataRef) == 1026) // 3D Cockpit
-        {
-            float elapsedTime = XPLMGetElapsedTime() - lastMouseUsageTime;
+    BLUfxHistogram *histogram = (BLUfxHistogram *) inRefcon;
 
-            if (elapsedTime <= disableCinemaVeriteTime)
-                XPLMSetDatai(cinemaVeriteDataRef, 0);
-            else
-                XPLMSetDatai(cinemaVeriteDataRef, 1);
-        }
-        else
-            XPLMSetDatai(cinemaVeriteDataRef, 1);
-    }
+    if (outValues == NULL)
+        return HISTOGRAM_BUCKET_COUNT;
 
-    return -1.0f;
-}
+    if (inOffset < 0)
+        return 0;
 
-// removes the fragment-shader from video memory, if deleteProgram is set the shader-program is also removed
-static void CleanupShader(int deleteProgram = 0)
-{
-    glDetachShader(program, fragmentShader);
-    glDeleteShader(fragmentShader);
+    int count = 0;
+    for (int i = inOffset; i < HISTOGRAM_BUCKET_COUNT && count < inMax; i++)
+        outValues[count++] = histogram->buckets[i];
 
-    if (deleteProgram)
-        glDeleteProgram(program);
+    return count;
 }
 
-// function to load, compile and link the fragment-shader
-static void InitShader(const char *fragmentShaderString)
+// get accessor for the frame_statistics/* DataRefs, the refcon points to the published value
+float GetFrameStatisticDataRefCallback(void* inRefcon)
 {
-    program = glCreateProgram();
-
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderString, 0);
-    glCompileShader(fragmentShader);
-    glAttachShader(program, fragmentShader);
-    GLint isFragmentShaderCompiled = GL_FALSE;
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &isFragmentShaderCompiled);
-    if (isFragmentShaderCompiled == GL_FALSE)
-    {
-        GLsizei maxLength = 2048;
-        GLchar *log = new GLchar[maxLength];
-        glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, log);
-        XPLMDebugString(NAME": The following error occured while compiling the fragment shader:\n");
-        XPLMDebugString(log);
-        delete[] log;
+    return *(float *) inRefcon;
+}
 
-        CleanupShader(1);
+// get accessor for dataref_cache DataRefs
+int GetDataRefCacheStatisticDataRefCallback(void* inRefcon)
+{
+    return *(int *) inRefcon;
+}
 
-        return;
-    }
+// get accessor for governor/enabled DataRef
+int GetQualityGovernorEnabledDataRefCallback(void* inRefcon)
+{
+    return qualityGovernorEnabled;
+}
 
-    glLinkProgram(program);
-    GLint isProgramLinked = GL_FALSE;
-    glGetProgramiv(program, GL_LINK_STATUS, &isProgramLinked);
-    if (isProgramLinked == GL_FALSE)
-    {
-        GLsizei maxLength = 2048;
-        GLchar *log = new GLchar[maxLength];
-        glGetShaderInfoLog(fragmentShader, maxLength, &maxLength, log);
-        XPLMDebugString(NAME": The following error occured while linking the shader program:\n");
-        XPLMDebugString(log);
-        delete[] log;
+// set accessor for governor/enabled DataRef
+void SetQualityGovernorEnabledDataRefCallback(void* inRefcon, int inValue)
+{
+    qualityGovernorEnabled = inValue != 0;
+}
 
-        CleanupShader(1);
+// get accessor for governor/tier DataRef
+int GetQualityTierDataRefCallback(void* inRefcon)
+{
+    return qualityTier;
+}
 
-        return;
-    }
+// get accessor for governor/skipped_frames DataRef
+int GetGovernorSkippedFramesDataRefCallback(void* inRefcon)
+{
+    return governorSkippedFrames;
+}
 
-    CleanupShader(0);
+// get accessor for limiter/frame_time_variance DataRef in square milliseconds
+float GetFrameTimeVarianceDataRefCallback(void* inRefcon)
+{
+    return (float) (limiter.frameTimeVariance * 1000000.0);
 }
 
-// get accessor for override_cinema_verite_control DataRef
-int GetOverrideControlCinemaVeriteDataRefCallback(void* inRefcon)
+// get accessor for limiter/measured_fps DataRef
+float GetMeasuredFpsDataRefCallback(void* inRefcon)
 {
-    return overrideControlCinemaVerite;
+    return limiter.frameTimeMean > 0.0 ? (float) (1.0 / limiter.frameTimeMean) : 0.0f;
 }
 
-// set accessor for override_control_cinema_verite DataRef
-void SetOverrideControlCinemaVeriteDataRefCallback(void* inRefcon, int inValue)
+// get accessor for limiter/spin_threshold_ms DataRef
+float GetSpinThresholdDataRefCallback(void* inRefcon)
 {
-    overrideControlCinemaVerite = inValue;
+    return (float) (spinThreshold * 1000.0);
 }
 
 // returns a float rounded to two decimal places
@@ -666,10 +2676,9 @@ static float Round(const float f)
 // sets the raleigh scale dataref to the selected raleigh scale value, passing reset = 1 resets the dataref to its default value
 static void UpdateRaleighScale(int reset)
 {
-    if (raleighScaleDataRef == NULL)
-        raleighScaleDataRef = XPLMFindDataRef("sim/private/controls/atmo/atmo_scale_raleigh");
-    if (raleighScaleDataRef != NULL)
-        XPLMSetDataf(raleighScaleDataRef, !reset ? raleighScale : DEFAULT_RALEIGH_SCALE);
+    // the sim resets the value when loading scenery, so the write must never be dropped as unchanged
+    InvalidateCachedDataRef(SIM_DATAREF_RALEIGH_SCALE);
+    SetCachedDataf(SIM_DATAREF_RALEIGH_SCALE, !reset ? raleighScale : DEFAULT_RALEIGH_SCALE);
 }
 
 // updates all caption widgets and slider positions associated with settings variables
@@ -680,43 +2689,43 @@ static void UpdateSettingsWidgets(void)
     XPSetWidgetProperty(controlCinemaVeriteCheckbox, xpProperty_ButtonState, controlCinemaVeriteEnabled);
 
     char stringBrightness[32];
-    sprintf(stringBrightness, "Brightness: %.2f", brightness);
+    sprintf(stringBrightness, "Brightness: %.2f", parameters.brightness);
     XPSetWidgetDescriptor(brightnessCaption, stringBrightness);
 
     char stringContrast[32];
-    sprintf(stringContrast, "Contrast: %.2f", contrast);
+    sprintf(stringContrast, "Contrast: %.2f", parameters.contrast);
     XPSetWidgetDescriptor(contrastCaption, stringContrast);
 
     char stringSaturation[32];
-    sprintf(stringSaturation, "Saturation: %.2f", saturation);
+    sprintf(stringSaturation, "Saturation: %.2f", parameters.saturation);
     XPSetWidgetDescriptor(saturationCaption, stringSaturation);
 
     char stringRedScale[32];
-    sprintf(stringRedScale, "Red Scale: %.2f", redScale);
+    sprintf(stringRedScale, "Red Scale: %.2f", parameters.redScale);
     XPSetWidgetDescriptor(redScaleCaption, stringRedScale);
 
     char stringGreenScale[32];
-    sprintf(stringGreenScale, "Green Scale: %.2f", greenScale);
+    sprintf(stringGreenScale, "Green Scale: %.2f", parameters.greenScale);
     XPSetWidgetDescriptor(greenScaleCaption, stringGreenScale);
 
     char stringBlueScale[32];
-    sprintf(stringBlueScale, "Blue Scale: %.2f", blueScale);
+    sprintf(stringBlueScale, "Blue Scale: %.2f", parameters.blueScale);
     XPSetWidgetDescriptor(blueScaleCaption, stringBlueScale);
 
     char stringRedOffset[32];
-    sprintf(stringRedOffset, "Red Offset: %.2f", redOffset);
+    sprintf(stringRedOffset, "Red Offset: %.2f", parameters.redOffset);
     XPSetWidgetDescriptor(redOffsetCaption, stringRedOffset);
 
     char stringGreenOffset[32];
-    sprintf(stringGreenOffset, "Green Offset: %.2f", greenOffset);
+    sprintf(stringGreenOffset, "Green Offset: %.2f", parameters.greenOffset);
     XPSetWidgetDescriptor(greenOffsetCaption, stringGreenOffset);
 
     char stringBlueOffset[32];
-    sprintf(stringBlueOffset, "Blue Offset: %.2f", blueOffset);
+    sprintf(stringBlueOffset, "Blue Offset: %.2f", parameters.blueOffset);
     XPSetWidgetDescriptor(blueOffsetCaption, stringBlueOffset);
 
     char stringVignette[32];
-    sprintf(stringVignette, "Vignette: %.2f", vignette);
+    sprintf(stringVignette, "Vignette: %.2f", parameters.vignette);
     XPSetWidgetDescriptor(vignetteCaption, stringVignette);
 
     char stringRaleighScale[32];
@@ -731,24 +2740,173 @@ static void UpdateSettingsWidgets(void)
     sprintf(stringDisableCinemaVeriteTime, "On input disable for: %.0f sec", disableCinemaVeriteTime);
     XPSetWidgetDescriptor(disableCinemaVeriteTimeCaption, stringDisableCinemaVeriteTime);
 
-    XPSetWidgetProperty(brightnessSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (brightness * 1000.0f));
-    XPSetWidgetProperty(contrastSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (contrast * 100.0f));
-    XPSetWidgetProperty(saturationSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (saturation * 100.0f));
-    XPSetWidgetProperty(redScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (redScale * 100.0f));
-    XPSetWidgetProperty(greenScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (greenScale * 100.0f));
-    XPSetWidgetProperty(blueScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (blueScale * 100.0f));
-    XPSetWidgetProperty(redOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (redOffset * 100.0f));
-    XPSetWidgetProperty(greenOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (greenOffset * 100.0f));
-    XPSetWidgetProperty(blueOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (blueOffset * 100.0f));
-    XPSetWidgetProperty(vignetteSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (vignette * 100.0f));
+    XPSetWidgetProperty(brightnessSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.brightness * 1000.0f));
+    XPSetWidgetProperty(contrastSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.contrast * 100.0f));
+    XPSetWidgetProperty(saturationSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.saturation * 100.0f));
+    XPSetWidgetProperty(redScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.redScale * 100.0f));
+    XPSetWidgetProperty(greenScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.greenScale * 100.0f));
+    XPSetWidgetProperty(blueScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.blueScale * 100.0f));
+    XPSetWidgetProperty(redOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.redOffset * 100.0f));
+    XPSetWidgetProperty(greenOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.greenOffset * 100.0f));
+    XPSetWidgetProperty(blueOffsetSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.blueOffset * 100.0f));
+    XPSetWidgetProperty(vignetteSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (parameters.vignette * 100.0f));
     XPSetWidgetProperty(raleighScaleSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) raleighScale);
     XPSetWidgetProperty(maxFpsSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (maxFps));
     XPSetWidgetProperty(disableCinemaVeriteTimeSlider, xpProperty_ScrollBarSliderPosition, (intptr_t) (disableCinemaVeriteTime));
 }
 
+// get accessor for the params/<parameter> DataRefs, the refcon points at the field of the parameters
+float GetParameterDataRefCallback(void* inRefcon)
+{
+    return *(float *) inRefcon;
+}
+
+// set accessor for the params/<parameter> DataRefs, the refcon points at the field of the parameters
+void SetParameterDataRefCallback(void* inRefcon, float inValue)
+{
+    CancelPresetTransition();
+    *(float *) inRefcon = inValue;
+    settingsWidgetsStale = 1;
+}
+
+// get accessor for params and transition/target DataRefs
+int GetParametersDataRefCallback(void* inRefcon, float *outValues, int inOffset, int inMax)
+{
+    if (outValues == NULL)
+        return PARAMETER_MAX;
+
+    if (inOffset < 0)
+        return 0;
+
+    const float *values = (const float *) inRefcon;
+    int count = 0;
+    for (int i = inOffset; i < PARAMETER_MAX && count < inMax; i++)
+        outValues[count++] = values[i];
+
+    return count;
+}
+
+// set accessor for the params DataRef, a whole parameter block can be set in a single call
+void SetParametersDataRefCallback(void* inRefcon, float *inValues, int inOffset, int inCount)
+{
+    CancelPresetTransition();
+
+    float *values = (float *) &parameters;
+    for (int i = 0; i < inCount && inOffset + i < PARAMETER_MAX; i++)
+    {
+        if (inOffset + i >= 0)
+            values[inOffset + i] = inValues[i];
+    }
+
+    settingsWidgetsStale = 1;
+}
+
+// set accessor for transition/target DataRef, it starts a crossfade to the written values
+void SetPresetTransitionTargetDataRefCallback(void* inRefcon, float *inValues, int inOffset, int inCount)
+{
+    BLUfxPreset target = presetTransition.to;
+    float *values = (float *) &target;
+    for (int i = 0; i < inCount && inOffset + i < PARAMETER_MAX; i++)
+    {
+        if (inOffset + i >= 0)
+            values[inOffset + i] = inValues[i];
+    }
+
+    StartPresetTransition(&target, -1);
+}
+
+// get accessor for transition/preset DataRef
+int GetPresetTransitionPresetDataRefCallback(void* inRefcon)
+{
+    return presetTransition.preset;
+}
+
+// set accessor for transition/preset DataRef, it starts a crossfade to the given preset
+void SetPresetTransitionPresetDataRefCallback(void* inRefcon, int inValue)
+{
+    if (inValue >= 0 && inValue < PRESET_MAX)
+        StartPresetTransition(&BLUfxPresets[inValue], inValue);
+}
+
+// get accessor for transition/duration DataRef
+float GetPresetTransitionTimeDataRefCallback(void* inRefcon)
+{
+    return presetTransitionTime;
+}
+
+// set accessor for transition/duration DataRef
+void SetPresetTransitionTimeDataRefCallback(void* inRefcon, float inValue)
+{
+    presetTransitionTime = std::max(inValue, 0.0f);
+}
+
+// get accessor for transition/easing DataRef
+int GetPresetTransitionEasingDataRefCallback(void* inRefcon)
+{
+    return presetTransitionEasing;
+}
+
+// set accessor for transition/easing DataRef
+void SetPresetTransitionEasingDataRefCallback(void* inRefcon, int inValue)
+{
+    if (inValue >= 0 && inValue < PRESET_TRANSITION_EASING_MAX)
+        presetTransitionEasing = inValue;
+}
+
+// get accessor for transition/progress DataRef
+float GetPresetTransitionProgressDataRefCallback(void* inRefcon)
+{
+    return presetTransition.progress;
+}
+
+// command-handler that crossfades to the next or previous preset
+static int PresetCommandHandler(XPLMCommandRef inCommand, XPLMCommandPhase inPhase, void *inRefcon)
+{
+    if (inPhase == xplm_CommandBegin)
+    {
+        int step = (int) (intptr_t) inRefcon;
+        int preset = presetTransition.preset >= 0 ? (presetTransition.preset + step + PRESET_MAX) % PRESET_MAX : 0;
+        StartPresetTransition(&BLUfxPresets[preset], preset);
+    }
+
+    return 1;
+}
+
+// get accessor for raleigh_scale DataRef
+float GetRaleighScaleDataRefCallback(void* inRefcon)
+{
+    return raleighScale;
+}
+
+// set accessor for raleigh_scale DataRef
+void SetRaleighScaleDataRefCallback(void* inRefcon, float inValue)
+{
+    raleighScale = inValue;
+    UpdateRaleighScale(0);
+    settingsWidgetsStale = 1;
+}
+
+// get accessor for max_fps DataRef
+float GetMaxFpsDataRefCallback(void* inRefcon)
+{
+    return maxFps;
+}
+
+// set accessor for max_fps DataRef, the limiter divides by the value so it has to stay positive
+void SetMaxFpsDataRefCallback(void* inRefcon, float inValue)
+{
+    if (inValue > 0.0f)
+    {
+        maxFps = inValue;
+        settingsWidgetsStale = 1;
+    }
+}
+
 // saves current settings to the config file
 static void SaveSettings(void)
 {
+    BLUfxTraceScope traceScope("SaveSettings", "config");
+
     std::fstream file;
     file.open(CONFIG_PATH, std::ios_base::out | std::ios_base::trunc);
 
@@ -757,19 +2915,30 @@ static void SaveSettings(void)
         file << "postProcesssingEnabled=" << postProcesssingEnabled << std::endl;
         file << "fpsLimiterEnabled=" << fpsLimiterEnabled << std::endl;
         file << "controlCinemaVeriteEnabled=" << controlCinemaVeriteEnabled << std::endl;
-        file << "brightness=" << brightness << std::endl;
-        file << "contrast=" << contrast << std::endl;
-        file << "saturation=" << saturation << std::endl;
-        file << "redScale=" << redScale << std::endl;
-        file << "greenScale=" << greenScale << std::endl;
-        file << "blueScale=" << blueScale << std::endl;
-        file << "redOffset=" << redOffset << std::endl;
-        file << "greenOffset=" << greenOffset << std::endl;
-        file << "blueOffset=" << blueOffset << std::endl;
-        file << "vignette=" << vignette << std::endl;
+        file << "brightness=" << parameters.brightness << std::endl;
+        file << "contrast=" << parameters.contrast << std::endl;
+        file << "saturation=" << parameters.saturation << std::endl;
+        file << "redScale=" << parameters.redScale << std::endl;
+        file << "greenScale=" << parameters.greenScale << std::endl;
+        file << "blueScale=" << parameters.blueScale << std::endl;
+        file << "redOffset=" << parameters.redOffset << std::endl;
+        file << "greenOffset=" << parameters.greenOffset << std::endl;
+        file << "blueOffset=" << parameters.blueOffset << std::endl;
+        file << "vignette=" << parameters.vignette << std::endl;
+        file << "vignetteCenterX=" << vignetteCenterX << std::endl;
+        file << "vignetteCenterY=" << vignetteCenterY << std::endl;
+        file << "vignetteRadiusX=" << vignetteRadiusX << std::endl;
+        file << "vignetteRadiusY=" << vignetteRadiusY << std::endl;
         file << "raleighScale=" << raleighScale << std::endl;
         file << "maxFps=" << maxFps << std::endl;
         file << "disableCinemaVeriteTime=" << disableCinemaVeriteTime << std::endl;
+        file << "lutEnabled=" << lutEnabled << std::endl;
+        file << "lutSize=" << lutSize << std::endl;
+        file << "tracingEnabled=" << tracingEnabled << std::endl;
+        file << "frameStatisticsOverlayEnabled=" << frameStatisticsOverlayEnabled << std::endl;
+        file << "qualityGovernorEnabled=" << qualityGovernorEnabled << std::endl;
+        file << "presetTransitionTime=" << presetTransitionTime << std::endl;
+        file << "presetTransitionEasing=" << presetTransitionEasing << std::endl;
 
         file.close();
     }
@@ -778,6 +2947,8 @@ static void SaveSettings(void)
 // loads settings from the config file
 static void LoadSettings(void)
 {
+    BLUfxTraceScope traceScope("LoadSettings", "config");
+
     std::ifstream file;
     file.open(CONFIG_PATH);
 
@@ -797,31 +2968,57 @@ static void LoadSettings(void)
             else if(line.find("controlCinemaVeriteEnabled") != std::string::npos)
                 iss >> controlCinemaVeriteEnabled;
             else if(line.find("brightness") != std::string::npos)
-                iss >> brightness;
+                iss >> parameters.brightness;
             else if(line.find("contrast") != std::string::npos)
-                iss >> contrast;
+                iss >> parameters.contrast;
             else if(line.find("saturation") != std::string::npos)
-                iss >> saturation;
+                iss >> parameters.saturation;
             else if(line.find("redScale") != std::string::npos)
-                iss >> redScale;
+                iss >> parameters.redScale;
             else if(line.find("greenScale") != std::string::npos)
-                iss >> greenScale;
+                iss >> parameters.greenScale;
             else if(line.find("blueScale") != std::string::npos)
-                iss >> blueScale;
+                iss >> parameters.blueScale;
             else if(line.find("redOffset") != std::string::npos)
-                iss >> redOffset;
+                iss >> parameters.redOffset;
             else if(line.find("greenOffset") != std::string::npos)
-                iss >> greenOffset;
+                iss >> parameters.greenOffset;
             else if(line.find("blueOffset") != std::string::npos)
-                iss >> blueOffset;
+                iss >> parameters.blueOffset;
+            else if(line.find("vignetteCenterX") != std::string::npos)
+                iss >> vignetteCenterX;
+            else if(line.find("vignetteCenterY") != std::string::npos)
+                iss >> vignetteCenterY;
+            else if(line.find("vignetteRadiusX") != std::string::npos)
+                iss >> vignetteRadiusX;
+            else if(line.find("vignetteRadiusY") != std::string::npos)
+                iss >> vignetteRadiusY;
             else if(line.find("vignette") != std::string::npos)
-                iss >> vignette;
+                iss >> parameters.vignette;
             else if(line.find("raleighScale") != std::string::npos)
                 iss >> raleighScale;
             else if(line.find("maxFps") != std::string::npos)
                 iss >> maxFps;
             else if(line.find("disableCinemaVeriteTime") != std::string::npos)
                 iss >> disableCinemaVeriteTime;
+            else if(line.find("lutEnabled") != std::string::npos)
+                iss >> lutEnabled;
+            else if(line.find("lutSize") != std::string::npos)
+                iss >> lutSize;
+            else if(line.find("tracingEnabled") != std::string::npos)
+            {
+                int enabled = 0;
+                iss >> enabled;
+                SetTracingEnabled(enabled);
+            }
+            else if(line.find("frameStatisticsOverlayEnabled") != std::string::npos)
+                iss >> frameStatisticsOverlayEnabled;
+            else if(line.find("qualityGovernorEnabled") != std::string::npos)
+                iss >> qualityGovernorEnabled;
+            else if(line.find("presetTransitionTime") != std::string::npos)
+                iss >> presetTransitionTime;
+            else if(line.find("presetTransitionEasing") != std::string::npos)
+                iss >> presetTransitionEasing;
         }
 
         file.close();
@@ -839,6 +3036,15 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
             XPHideWidget(settingsWidget);
         }
     }
+    else if (inMessage == xpMsg_Draw)
+    {
+        // show settings changed by other plugins
+        if (settingsWidgetsStale)
+        {
+            UpdateSettingsWidgets();
+            settingsWidgetsStale = 0;
+        }
+    }
     else if (inMessage == xpMsg_ButtonStateChanged)
     {
         if (inParam1 == (long) postProcessingCheckbox)
@@ -847,14 +3053,11 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
 
             if (!postProcesssingEnabled)
             {
-                XPLMUnregisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
                 UpdateRaleighScale(1);
+                CleanupGLResources();
             }
             else
-            {
-                XPLMRegisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
                 UpdateRaleighScale(0);
-            }
 
         }
         else if (inParam1 == (long) fpsLimiterCheckbox)
@@ -862,14 +3065,12 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
             fpsLimiterEnabled = (int) XPGetWidgetProperty(fpsLimiterCheckbox, xpProperty_ButtonState, 0);
 
             if (!fpsLimiterEnabled)
-            {
-                XPLMUnregisterFlightLoopCallback(LimiterFlightCallback, NULL);
-                XPLMUnregisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
-            }
+                CancelTask(TASK_LIMITER);
             else
             {
-                XPLMRegisterFlightLoopCallback(LimiterFlightCallback, -1, NULL);
-                XPLMRegisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
+                // the frame time statistics of an earlier run must not see the pause as one long frame
+                limiter.lastFrameTime = 0.0;
+                ScheduleTask(TASK_LIMITER, 0.0f);
             }
 
         }
@@ -878,34 +3079,41 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
             controlCinemaVeriteEnabled = (int) XPGetWidgetProperty(controlCinemaVeriteCheckbox, xpProperty_ButtonState, 0);
 
             if (!controlCinemaVeriteEnabled)
-                XPLMUnregisterFlightLoopCallback(ControlCinemaVeriteCallback, NULL);
+                CancelTask(TASK_CONTROL_CINEMA_VERITE);
             else
-                XPLMRegisterFlightLoopCallback(ControlCinemaVeriteCallback, -1, NULL);
+            {
+                // the DataRef may have been changed by somebody else in the meantime
+                WakeCinemaVeriteController(1);
+            }
 
         }
     }
     else if (inMessage == xpMsg_ScrollBarSliderPositionChanged)
     {
+        // a running crossfade would overwrite the slider value in the next frame
+        if (inParam1 != (long) raleighScaleSlider && inParam1 != (long) maxFpsSlider && inParam1 != (long) disableCinemaVeriteTimeSlider)
+            CancelPresetTransition();
+
         if (inParam1 == (long) brightnessSlider)
-            brightness = Round(XPGetWidgetProperty(brightnessSlider, xpProperty_ScrollBarSliderPosition, 0) / 1000.0f);
+            parameters.brightness = Round(XPGetWidgetProperty(brightnessSlider, xpProperty_ScrollBarSliderPosition, 0) / 1000.0f);
         else if (inParam1 == (long) contrastSlider)
-            contrast = Round(XPGetWidgetProperty(contrastSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.contrast = Round(XPGetWidgetProperty(contrastSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) saturationSlider)
-            saturation = Round(XPGetWidgetProperty(saturationSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.saturation = Round(XPGetWidgetProperty(saturationSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) redScaleSlider)
-            redScale = Round(XPGetWidgetProperty(redScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.redScale = Round(XPGetWidgetProperty(redScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) greenScaleSlider)
-            greenScale = Round(XPGetWidgetProperty(greenScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.greenScale = Round(XPGetWidgetProperty(greenScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) blueScaleSlider)
-            blueScale = Round(XPGetWidgetProperty(blueScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.blueScale = Round(XPGetWidgetProperty(blueScaleSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) redOffsetSlider)
-            redOffset = Round(XPGetWidgetProperty(redOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.redOffset = Round(XPGetWidgetProperty(redOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) greenOffsetSlider)
-            greenOffset = Round(XPGetWidgetProperty(greenOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.greenOffset = Round(XPGetWidgetProperty(greenOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) blueOffsetSlider)
-            blueOffset = Round(XPGetWidgetProperty(blueOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.blueOffset = Round(XPGetWidgetProperty(blueOffsetSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) vignetteSlider)
-            vignette = Round(XPGetWidgetProperty(vignetteSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
+            parameters.vignette = Round(XPGetWidgetProperty(vignetteSlider, xpProperty_ScrollBarSliderPosition, 0) / 100.0f);
         else if (inParam1 == (long) raleighScaleSlider)
         {
             raleighScale = Round((float) XPGetWidgetProperty(raleighScaleSlider, xpProperty_ScrollBarSliderPosition, 0));
@@ -914,7 +3122,10 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
         else if (inParam1 == (long) maxFpsSlider)
             maxFps = (float) (int) XPGetWidgetProperty(maxFpsSlider, xpProperty_ScrollBarSliderPosition, 0);
         else if (inParam1 == (long) disableCinemaVeriteTimeSlider)
+        {
             disableCinemaVeriteTime = (float) (int) XPGetWidgetProperty(disableCinemaVeriteTimeSlider, xpProperty_ScrollBarSliderPosition, 0);
+            WakeCinemaVeriteController(0);
+        }
 
         UpdateSettingsWidgets();
     }
@@ -932,16 +3143,7 @@ static int SettingsWidgetHandler(XPWidgetMessage inMessage, XPWidgetID inWidget,
             {
                 if ((long) presetButtons[i] == (long) inParam1)
                 {
-                    brightness = BLUfxPresets[i].brightness;
-                    contrast = BLUfxPresets[i].contrast;
-                    saturation = BLUfxPresets[i].saturation;
-                    redScale = BLUfxPresets[i].redScale;
-                    greenScale = BLUfxPresets[i].greenScale;
-                    blueScale = BLUfxPresets[i].blueScale;
-                    redOffset = BLUfxPresets[i].redOffset;
-                    greenOffset = BLUfxPresets[i].greenOffset;
-                    blueOffset = BLUfxPresets[i].blueOffset;
-                    vignette = BLUfxPresets[i].vignette;
+                    StartPresetTransition(&BLUfxPresets[i], i);
 
                     break;
                 }
@@ -989,7 +3191,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add brightness caption
             char stringBrightness[32];
-            sprintf(stringBrightness, "Brightness: %.2f", brightness);
+            sprintf(stringBrightness, "Brightness: %.2f", parameters.brightness);
             brightnessCaption = XPCreateWidget(x + 30, y - 90, x2 - 50, y - 105, 1, stringBrightness, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add brightness slider
@@ -999,7 +3201,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add contrast caption
             char stringContrast[32];
-            sprintf(stringContrast, "Contrast: %.2f", contrast);
+            sprintf(stringContrast, "Contrast: %.2f", parameters.contrast);
             contrastCaption = XPCreateWidget(x + 30, y - 110, x2 - 50, y - 125, 1, stringContrast, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add contrast slider
@@ -1009,7 +3211,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add saturation caption
             char stringSaturation[32];
-            sprintf(stringSaturation, "Saturation: %.2f", saturation);
+            sprintf(stringSaturation, "Saturation: %.2f", parameters.saturation);
             saturationCaption = XPCreateWidget(x + 30, y - 130, x2 - 50, y - 145, 1, stringSaturation, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add saturation slider
@@ -1019,7 +3221,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add red scale caption
             char stringRedScale[32];
-            sprintf(stringRedScale, "Red Scale: %.2f", redScale);
+            sprintf(stringRedScale, "Red Scale: %.2f", parameters.redScale);
             redScaleCaption = XPCreateWidget(x + 30, y - 150, x2 - 50, y - 165, 1, stringRedScale, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add red scale slider
@@ -1029,7 +3231,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add green scale caption
             char stringGreenScale[32];
-            sprintf(stringGreenScale, "Green Scale: %.2f", greenScale);
+            sprintf(stringGreenScale, "Green Scale: %.2f", parameters.greenScale);
             greenScaleCaption = XPCreateWidget(x + 30, y - 170, x2 - 50, y - 185, 1, stringGreenScale, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add green scale slider
@@ -1039,7 +3241,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add blue scale caption
             char stringBlueScale[32];
-            sprintf(stringBlueScale, "Blue Scale: %.2f", blueScale);
+            sprintf(stringBlueScale, "Blue Scale: %.2f", parameters.blueScale);
             blueScaleCaption = XPCreateWidget(x + 30, y - 190, x2 - 50, y - 205, 1, stringBlueScale, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add blue scale slider
@@ -1049,7 +3251,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add red offset caption
             char stringRedOffset[32];
-            sprintf(stringRedOffset, "Red Offset: %.2f", redOffset);
+            sprintf(stringRedOffset, "Red Offset: %.2f", parameters.redOffset);
             redOffsetCaption = XPCreateWidget(x + 30, y - 210, x2 - 50, y - 225, 1, stringRedOffset, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add red offset slider
@@ -1059,7 +3261,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add green offset caption
             char stringGreenOffset[32];
-            sprintf(stringGreenOffset, "Green Offset: %.2f", greenOffset);
+            sprintf(stringGreenOffset, "Green Offset: %.2f", parameters.greenOffset);
             greenOffsetCaption = XPCreateWidget(x + 30, y - 230, x2 - 50, y - 245, 1, stringGreenOffset, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add green offset slider
@@ -1069,7 +3271,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add blue offset caption
             char stringBlueOffset[32];
-            sprintf(stringBlueOffset, "Blue Offset: %.2f", blueOffset);
+            sprintf(stringBlueOffset, "Blue Offset: %.2f", parameters.blueOffset);
             blueOffsetCaption = XPCreateWidget(x + 30, y - 250, x2 - 50, y - 265, 1, stringBlueOffset, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add blue offset slider
@@ -1079,7 +3281,7 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
 
             // add vignette caption
             char stringVignette[32];
-            sprintf(stringVignette, "Vignette: %.2f", vignette);
+            sprintf(stringVignette, "Vignette: %.2f", parameters.vignette);
             vignetteCaption = XPCreateWidget(x + 30, y - 270, x2 - 50, y - 285, 1, stringVignette, 0, settingsWidget, xpWidgetClass_Caption);
 
             // add vignette slider
@@ -1253,6 +3455,25 @@ static void MenuHandlerCallback(void *inMenuRef, void *inItemRef)
                 XPShowWidget(settingsWidget);
         }
     }
+    // enable tracing menu entry
+    else if ((long) inItemRef == 1)
+    {
+        SetTracingEnabled(!tracingEnabled);
+        SaveSettings();
+    }
+    // save trace menu entry
+    else if ((long) inItemRef == 2)
+        SaveTrace();
+    // show frame statistics menu entry
+    else if ((long) inItemRef == 3)
+    {
+        frameStatisticsOverlayEnabled = !frameStatisticsOverlayEnabled;
+        XPLMCheckMenuItem(menu, 3, frameStatisticsOverlayEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+        SaveSettings();
+    }
+    // save frame times menu entry
+    else if ((long) inItemRef == 4)
+        SaveFrameTimes();
 }
 
 static void DrawWindow(XPLMWindowID inWindowID, void *inRefcon)
@@ -1265,7 +3486,7 @@ static void HandleKey(XPLMWindowID inWindowID, char inKey, XPLMKeyFlags inFlags,
 
 static int HandleMouseClick(XPLMWindowID inWindowID, int x, int y, XPLMMouseStatus inMouse, void *inRefcon)
 {
-    lastMouseUsageTime = XPLMGetElapsedTime();
+    UpdateMouseUsage();
 
     return 0;
 }
@@ -1276,7 +3497,7 @@ static XPLMCursorStatus HandleCursor(XPLMWindowID inWindowID, int x, int y, void
 
     if (x != lastX || y != lastY)
     {
-        lastMouseUsageTime = XPLMGetElapsedTime();
+        UpdateMouseUsage();
         lastX = x;
         lastY = y;
     }
@@ -1286,36 +3507,95 @@ static XPLMCursorStatus HandleCursor(XPLMWindowID inWindowID, int x, int y, void
 
 static int HandleMouseWheel(XPLMWindowID inWindowID, int x, int y, int wheel, int clicks, void *inRefcon)
 {
-    lastMouseUsageTime = XPLMGetElapsedTime();
+    UpdateMouseUsage();
 
     return 0;
 }
 
 PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
 {
+    double startTime = GetMonotonicTime();
+
     // set plugin info
     strcpy(outName, NAME);
-    strcpy(outSig, "de.bwravencl." NAME_LOWERCASE);
+    strcpy(outSig, BLU_FX_PLUGIN_SIGNATURE);
     strcpy(outDesc, NAME " enhances your X-Plane experience!");
 
-    // prepare fragment-shader
-    InitShader(FRAGMENT_SHADER);
-
     // obtain datarefs
-    cinemaVeriteDataRef = XPLMFindDataRef("sim/graphics/view/cinema_verite");
-    viewTypeDataRef = XPLMFindDataRef("sim/graphics/view/view_type");
     ignitionKeyDataRef = XPLMFindDataRef("sim/cockpit2/engine/actuators/ignition_key");
 
-    // register own dataref
+    // register own datarefs
     overrideControlCinemaVeriteDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/override_control_cinema_verite", xplmType_Int,  1, GetOverrideControlCinemaVeriteDataRefCallback, SetOverrideControlCinemaVeriteDataRefCallback,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    for (int i = 0; i < PARAMETER_MAX; i++)
+    {
+        char dataRefName[64];
+        sprintf(dataRefName, NAME_LOWERCASE "/params/%s", uniformNames[i]);
+        parameterDataRefs[i] = XPLMRegisterDataAccessor(dataRefName, xplmType_Float,  1, NULL, NULL,  GetParameterDataRefCallback, SetParameterDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &((float *) &parameters)[i], &((float *) &parameters)[i]);
+    }
+    parametersDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/params", xplmType_FloatArray,  1, NULL, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, GetParametersDataRefCallback, SetParametersDataRefCallback, NULL, NULL, &parameters, NULL);
+    presetTransitionPresetDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/transition/preset", xplmType_Int,  1, GetPresetTransitionPresetDataRefCallback, SetPresetTransitionPresetDataRefCallback,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    presetTransitionTargetDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/transition/target", xplmType_FloatArray,  1, NULL, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, GetParametersDataRefCallback, SetPresetTransitionTargetDataRefCallback, NULL, NULL, &presetTransition.to, NULL);
+    presetTransitionTimeDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/transition/duration", xplmType_Float,  1, NULL, NULL,  GetPresetTransitionTimeDataRefCallback, SetPresetTransitionTimeDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    presetTransitionEasingDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/transition/easing", xplmType_Int,  1, GetPresetTransitionEasingDataRefCallback, SetPresetTransitionEasingDataRefCallback,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    presetTransitionProgressDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/transition/progress", xplmType_Float,  0, NULL, NULL,  GetPresetTransitionProgressDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    raleighScaleDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/raleigh_scale", xplmType_Float,  1, NULL, NULL,  GetRaleighScaleDataRefCallback, SetRaleighScaleDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    maxFpsDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/max_fps", xplmType_Float,  1, NULL, NULL,  GetMaxFpsDataRefCallback, SetMaxFpsDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    bypassedFramesDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/bypassed_frames", xplmType_Int,  0, GetBypassedFramesDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    renderTargetMemoryDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/render_target_memory", xplmType_Int,  0, GetRenderTargetMemoryDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    for (int i = 0; i < FRAME_STATISTIC_MAX; i++)
+    {
+        char dataRefName[64];
+        sprintf(dataRefName, NAME_LOWERCASE "/frame_statistics/%s", frameStatisticNames[i]);
+        frameStatisticDataRefs[i] = XPLMRegisterDataAccessor(dataRefName, xplmType_Float,  0, NULL, NULL,  GetFrameStatisticDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &frameStatistics[i], NULL);
+    }
+    for (int i = 0; i < DATAREF_CACHE_STATISTIC_MAX; i++)
+    {
+        char dataRefName[64];
+        sprintf(dataRefName, NAME_LOWERCASE "/dataref_cache/%s", dataRefCacheStatisticNames[i]);
+        dataRefCacheStatisticDataRefs[i] = XPLMRegisterDataAccessor(dataRefName, xplmType_Int,  0, GetDataRefCacheStatisticDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &dataRefCacheStatistics[i], NULL);
+    }
+    qualityGovernorEnabledDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/governor/enabled", xplmType_Int,  1, GetQualityGovernorEnabledDataRefCallback, SetQualityGovernorEnabledDataRefCallback,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    qualityTierDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/governor/tier", xplmType_Int,  0, GetQualityTierDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    governorSkippedFramesDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/governor/skipped_frames", xplmType_Int,  0, GetGovernorSkippedFramesDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    frameTimeVarianceDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/limiter/frame_time_variance", xplmType_Float,  0, NULL, NULL,  GetFrameTimeVarianceDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    measuredFpsDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/limiter/measured_fps", xplmType_Float,  0, NULL, NULL,  GetMeasuredFpsDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    spinThresholdDataRef = XPLMRegisterDataAccessor(NAME_LOWERCASE "/limiter/spin_threshold_ms", xplmType_Float,  0, NULL, NULL,  GetSpinThresholdDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    for (int i = 0; i < GPU_TIMER_MAX; i++)
+    {
+        for (int j = 0; j < GPU_STATISTIC_MAX; j++)
+        {
+            char dataRefName[64];
+            sprintf(dataRefName, NAME_LOWERCASE "/perf/gpu_%s_%s_ms", gpuTimerNames[i], gpuStatisticNames[j]);
+            gpuTimerDataRefs[i][j] = XPLMRegisterDataAccessor(dataRefName, xplmType_Float,  0, NULL, NULL,  GetGpuTimerStatisticDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &gpuTimers[i].statistics[j], NULL);
+        }
+    }
+    for (int i = 0; i < CALLBACK_MAX; i++)
+    {
+        char dataRefName[CPU_STATISTIC_MAX][80];
+        for (int j = 0; j < CPU_STATISTIC_MAX; j++)
+            sprintf(dataRefName[j], NAME_LOWERCASE "/perf/cpu_%s_%s", callbackNames[i], cpuStatisticNames[j]);
+
+        cpuTimerDataRefs[i][CPU_STATISTIC_CALLS] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_CALLS], xplmType_Int,  0, GetCpuTimerCallsDataRefCallback, NULL,  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+        cpuTimerDataRefs[i][CPU_STATISTIC_AVERAGE] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_AVERAGE], xplmType_Float,  0, NULL, NULL,  GetCpuTimerAverageDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+        cpuTimerDataRefs[i][CPU_STATISTIC_P50] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_P50], xplmType_Float,  0, NULL, NULL,  GetCpuTimerP50DataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+        cpuTimerDataRefs[i][CPU_STATISTIC_P99] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_P99], xplmType_Float,  0, NULL, NULL,  GetCpuTimerP99DataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+        cpuTimerDataRefs[i][CPU_STATISTIC_MAXIMUM] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_MAXIMUM], xplmType_Float,  0, NULL, NULL,  GetCpuTimerMaximumDataRefCallback, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+        cpuTimerDataRefs[i][CPU_STATISTIC_HISTOGRAM] = XPLMRegisterDataAccessor(dataRefName[CPU_STATISTIC_HISTOGRAM], xplmType_IntArray,  0, NULL, NULL,  NULL, NULL, NULL, NULL, GetCpuTimerHistogramDataRefCallback, NULL, NULL, NULL, NULL, NULL, &callbackHistograms[i], NULL);
+    }
 
     // create menu-entries
     int subMenuItem = XPLMAppendMenuItem(XPLMFindPluginsMenu(), NAME, 0, 1);
-    XPLMMenuID menu = XPLMCreateMenu(NAME, XPLMFindPluginsMenu(), subMenuItem, MenuHandlerCallback, 0);
+    menu = XPLMCreateMenu(NAME, XPLMFindPluginsMenu(), subMenuItem, MenuHandlerCallback, 0);
     XPLMAppendMenuItem(menu, "Settings", (void*) 0, 1);
+    XPLMAppendMenuItem(menu, "Enable Tracing", (void*) 1, 1);
+    XPLMAppendMenuItem(menu, "Save Trace", (void*) 2, 1);
+    XPLMAppendMenuItem(menu, "Show Frame Statistics", (void*) 3, 1);
+    XPLMAppendMenuItem(menu, "Save Frame Times", (void*) 4, 1);
 
     // read and apply config file
     LoadSettings();
+    XPLMCheckMenuItem(menu, 1, tracingEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+    XPLMCheckMenuItem(menu, 3, frameStatisticsOverlayEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
 
     // create fake window
     XPLMCreateWindow_t fakeWindowParameters;
@@ -1334,46 +3614,113 @@ PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc)
     fakeWindow = XPLMCreateWindowEx(&fakeWindowParameters);
     XPLMSetWindowPositioningMode(fakeWindow, xplm_WindowFullScreenOnAllMonitors, -1);
 
-    // register flight loop callbacks
-    XPLMRegisterFlightLoopCallback(UpdateFakeWindowCallback, -1, NULL);
+    // the target of the transition DataRefs starts out as the loaded parameters
+    presetTransition.to = parameters;
+    presetTransition.progress = 1.0f;
+
+    // create and register preset commands
+    nextPresetCommand = XPLMCreateCommand(NAME_LOWERCASE "/next_preset", "Crossfade to the next " NAME " preset");
+    previousPresetCommand = XPLMCreateCommand(NAME_LOWERCASE "/previous_preset", "Crossfade to the previous " NAME " preset");
+    XPLMRegisterCommandHandler(nextPresetCommand, PresetCommandHandler, 1, (void *) 1);
+    XPLMRegisterCommandHandler(previousPresetCommand, PresetCommandHandler, 1, (void *) -1);
+
+    // create the flight loop dispatcher and schedule its tasks
+    XPLMCreateFlightLoop_t flightLoopParameters;
+    flightLoopParameters.structSize = sizeof(flightLoopParameters);
+    flightLoopParameters.phase = xplm_FlightLoop_Phase_BeforeFlightModel;
+    flightLoopParameters.callbackFunc = DispatchTasksCallback;
+    flightLoopParameters.refcon = NULL;
+    dispatcherFlightLoop = XPLMCreateFlightLoop(&flightLoopParameters);
+
+    ScheduleTask(TASK_UPDATE_FAKE_WINDOW, 0.0f);
+    ScheduleTask(TASK_BRING_FAKE_WINDOW_TO_FRONT, 0.0f);
     if (fpsLimiterEnabled)
-        XPLMRegisterFlightLoopCallback(LimiterFlightCallback, -1, NULL);
+        ScheduleTask(TASK_LIMITER, 0.0f);
     if (controlCinemaVeriteEnabled)
-        XPLMRegisterFlightLoopCallback(ControlCinemaVeriteCallback, -1, NULL);
+        ScheduleTask(TASK_CONTROL_CINEMA_VERITE, 0.0f);
 
-    // register draw callbacks
-    if (postProcesssingEnabled)
-        XPLMRegisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
-    if (fpsLimiterEnabled)
-        XPLMRegisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
+    // register draw callbacks, they return right away while their feature is disabled
+    XPLMRegisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
+    XPLMRegisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
+    XPLMRegisterDrawCallback(FrameStatisticsCallback, xplm_Phase_Window, 0, NULL);
+
+    char message[64];
+    sprintf(message, NAME": Started in %.2f ms\n", (GetMonotonicTime() - startTime) * 1000.0);
+    XPLMDebugString(message);
 
     return 1;
 }
 
 PLUGIN_API void XPluginStop(void)
 {
-    CleanupShader(1);
+    LogCallbackStatistics();
 
-    // unregister own DataRef
+    CleanupGLResources();
+
+    // unregister own DataRefs
     XPLMUnregisterDataAccessor(overrideControlCinemaVeriteDataRef);
+    for (int i = 0; i < PARAMETER_MAX; i++)
+        XPLMUnregisterDataAccessor(parameterDataRefs[i]);
+    XPLMUnregisterDataAccessor(parametersDataRef);
+    XPLMUnregisterDataAccessor(presetTransitionPresetDataRef);
+    XPLMUnregisterDataAccessor(presetTransitionTargetDataRef);
+    XPLMUnregisterDataAccessor(presetTransitionTimeDataRef);
+    XPLMUnregisterDataAccessor(presetTransitionEasingDataRef);
+    XPLMUnregisterDataAccessor(presetTransitionProgressDataRef);
+    XPLMUnregisterDataAccessor(raleighScaleDataRef);
+    XPLMUnregisterDataAccessor(maxFpsDataRef);
+    XPLMUnregisterDataAccessor(bypassedFramesDataRef);
+    XPLMUnregisterDataAccessor(renderTargetMemoryDataRef);
+    for (int i = 0; i < FRAME_STATISTIC_MAX; i++)
+        XPLMUnregisterDataAccessor(frameStatisticDataRefs[i]);
+    for (int i = 0; i < DATAREF_CACHE_STATISTIC_MAX; i++)
+        XPLMUnregisterDataAccessor(dataRefCacheStatisticDataRefs[i]);
+    XPLMUnregisterDataAccessor(qualityGovernorEnabledDataRef);
+    XPLMUnregisterDataAccessor(qualityTierDataRef);
+    XPLMUnregisterDataAccessor(governorSkippedFramesDataRef);
+    XPLMUnregisterDataAccessor(frameTimeVarianceDataRef);
+    XPLMUnregisterDataAccessor(measuredFpsDataRef);
+    XPLMUnregisterDataAccessor(spinThresholdDataRef);
+    for (int i = 0; i < GPU_TIMER_MAX; i++)
+    {
+        for (int j = 0; j < GPU_STATISTIC_MAX; j++)
+            XPLMUnregisterDataAccessor(gpuTimerDataRefs[i][j]);
+    }
+    for (int i = 0; i < CALLBACK_MAX; i++)
+    {
+        for (int j = 0; j < CPU_STATISTIC_MAX; j++)
+            XPLMUnregisterDataAccessor(cpuTimerDataRefs[i][j]);
+    }
 
-    // unregister flight loop callbacks
-    XPLMUnregisterFlightLoopCallback(UpdateFakeWindowCallback, NULL);
-    if (fpsLimiterEnabled)
-        XPLMUnregisterFlightLoopCallback(LimiterFlightCallback, NULL);
-    if (controlCinemaVeriteEnabled)
-        XPLMUnregisterFlightLoopCallback(ControlCinemaVeriteCallback, NULL);
+    // unregister preset commands
+    XPLMUnregisterCommandHandler(nextPresetCommand, PresetCommandHandler, 1, (void *) 1);
+    XPLMUnregisterCommandHandler(previousPresetCommand, PresetCommandHandler, 1, (void *) -1);
+
+    // destroy the flight loop dispatcher
+    XPLMDestroyFlightLoop(dispatcherFlightLoop);
+    dispatcherFlightLoop = NULL;
+    scheduledTaskCount = 0;
 
     // unregister draw callbacks
-    if (postProcesssingEnabled)
-        XPLMUnregisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
-    if (fpsLimiterEnabled)
-        XPLMUnregisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
+    XPLMUnregisterDrawCallback(PostProcessingCallback, xplm_Phase_Window, 1, NULL);
+    XPLMUnregisterDrawCallback(LimiterDrawCallback, xplm_Phase_Terrain, 1, NULL);
+    XPLMUnregisterDrawCallback(FrameStatisticsCallback, xplm_Phase_Window, 0, NULL);
+
+    // free the trace ring
+    tracingEnabled = 0;
+    delete[] traceEvents;
+    traceEvents = NULL;
 }
 
 PLUGIN_API void XPluginDisable(void)
 {
+    // no more frames are drawn, so the reset has to reach the sim right away
     UpdateRaleighScale(1);
+    FlushDataRefCache();
+    CleanupGLResources();
+
+    // end all open transitions
+    transitionDepth = 0;
 }
 
 PLUGIN_API int XPluginEnable(void)
@@ -1384,7 +3731,48 @@ PLUGIN_API int XPluginEnable(void)
 PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFromWho, long inMessage, void *inParam)
 {
     if (inMessage == XPLM_MSG_PLANE_LOADED)
-        bringFakeWindowToFront = 0;
+        ScheduleTask(TASK_BRING_FAKE_WINDOW_TO_FRONT, 0.0f);
     else if (inMessage == XPLM_MSG_SCENERY_LOADED)
         UpdateRaleighScale(0);
+    else if (inMessage == BLU_FX_MSG_SET_PARAMETER_BLOCK)
+    {
+        const BLUfxParameterBlock *parameterBlock = (const BLUfxParameterBlock *) inParam;
+        if (parameterBlock != NULL && parameterBlock->version >= 1 && parameterBlock->structSize >= (int) sizeof(BLUfxParameterBlock))
+        {
+            memcpy(&pendingParameters, parameterBlock->parameters, sizeof(pendingParameters));
+            pendingParametersValid = 1;
+        }
+    }
+    else if (inMessage == BLU_FX_MSG_SELECT_PRESET)
+    {
+        const BLUfxPresetSelection *presetSelection = (const BLUfxPresetSelection *) inParam;
+        if (presetSelection != NULL && presetSelection->version >= 1 && presetSelection->structSize >= (int) sizeof(BLUfxPresetSelection) && presetSelection->preset >= 0 && presetSelection->preset < PRESET_MAX)
+        {
+            pendingParameters = BLUfxPresets[presetSelection->preset];
+            pendingParametersValid = 1;
+        }
+    }
+    else if (inMessage == BLU_FX_MSG_BEGIN_TRANSITION)
+    {
+        if (transitionDepth++ == 0)
+            transitionFrames = 0;
+    }
+    else if (inMessage == BLU_FX_MSG_END_TRANSITION)
+    {
+        if (transitionDepth > 0)
+            transitionDepth--;
+    }
+    else if (inMessage == BLU_FX_MSG_QUERY_STATS)
+    {
+        BLUfxStats *stats = (BLUfxStats *) inParam;
+        if (stats != NULL && stats->version >= 1 && stats->structSize >= (int) sizeof(BLUfxStats))
+        {
+            stats->averageFps = frameStatistics[FRAME_STATISTIC_AVERAGE_FPS];
+            stats->onePercentLowFps = frameStatistics[FRAME_STATISTIC_ONE_PERCENT_LOW_FPS];
+            stats->pointOnePercentLowFps = frameStatistics[FRAME_STATISTIC_POINT_ONE_PERCENT_LOW_FPS];
+            stats->frameTimeDeviationMs = frameStatistics[FRAME_STATISTIC_FRAME_TIME_DEVIATION];
+            stats->qualityTier = qualityTier;
+            stats->bypassedFrames = bypassedFrames;
+        }
+    }
 }
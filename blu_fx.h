@@ -0,0 +1,90 @@
+/* Copyright (C) 2018  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// public interface of BLU-fx for other plugins, send the messages below with XPLMSendMessageToPlugin
+// every struct starts with structSize and version, set them to sizeof the struct and BLU_FX_MESSAGE_VERSION
+// parameter blocks and preset selections are applied together at the end of the frame
+
+#ifndef BLU_FX_H
+#define BLU_FX_H
+
+#define BLU_FX_PLUGIN_SIGNATURE "de.bwravencl.blu_fx"
+
+#define BLU_FX_MESSAGE_VERSION 1
+
+// sets all effect parameters at once, inParam points at a BLUfxParameterBlock
+#define BLU_FX_MSG_SET_PARAMETER_BLOCK 0x42460001
+
+// switches to one of the built-in presets, inParam points at a BLUfxPresetSelection
+#define BLU_FX_MSG_SELECT_PRESET 0x42460002
+
+// holds back parameter blocks and preset selections until the matching BLU_FX_MSG_END_TRANSITION, inParam is unused
+// transitions can be nested, they are ended by force after 600 frames or when BLU-fx is disabled
+#define BLU_FX_MSG_BEGIN_TRANSITION 0x42460003
+
+// ends a transition started by BLU_FX_MSG_BEGIN_TRANSITION, inParam is unused
+#define BLU_FX_MSG_END_TRANSITION 0x42460004
+
+// fills the BLUfxStats inParam points at
+#define BLU_FX_MSG_QUERY_STATS 0x42460005
+
+// indices of the values of a parameter block
+enum BLUfxBlockParameters_t
+{
+    BLU_FX_PARAMETER_BRIGHTNESS,
+    BLU_FX_PARAMETER_CONTRAST,
+    BLU_FX_PARAMETER_SATURATION,
+    BLU_FX_PARAMETER_RED_SCALE,
+    BLU_FX_PARAMETER_GREEN_SCALE,
+    BLU_FX_PARAMETER_BLUE_SCALE,
+    BLU_FX_PARAMETER_RED_OFFSET,
+    BLU_FX_PARAMETER_GREEN_OFFSET,
+    BLU_FX_PARAMETER_BLUE_OFFSET,
+    BLU_FX_PARAMETER_VIGNETTE,
+    BLU_FX_PARAMETER_COUNT
+};
+
+// payload of BLU_FX_MSG_SET_PARAMETER_BLOCK
+typedef struct BLUfxParameterBlock_t
+{
+    int structSize;
+    int version;
+    float parameters[BLU_FX_PARAMETER_COUNT];
+} BLUfxParameterBlock;
+
+// payload of BLU_FX_MSG_SELECT_PRESET, preset 0 is the default preset
+typedef struct BLUfxPresetSelection_t
+{
+    int structSize;
+    int version;
+    int preset;
+} BLUfxPresetSelection;
+
+// payload of BLU_FX_MSG_QUERY_STATS, qualityTier is 0 at full quality
+typedef struct BLUfxStats_t
+{
+    int structSize;
+    int version;
+    float averageFps;
+    float onePercentLowFps;
+    float pointOnePercentLowFps;
+    float frameTimeDeviationMs;
+    int qualityTier;
+    int bypassedFrames;
+} BLUfxStats;
+
+#endif
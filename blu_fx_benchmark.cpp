@@ -0,0 +1,127 @@
+/* Copyright (C) 2018  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// standalone benchmark of the CPU implementation of the post-processing pipeline, build it with 'make benchmark'
+
+#include "blu_fx_kernel.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// minimum time each configuration is measured for
+#define MIN_BENCHMARK_TIME 0.25
+
+struct Resolution_t
+{
+    const char *name;
+    int width;
+    int height;
+};
+typedef Resolution_t Resolution;
+
+static const Resolution resolutions[] =
+{
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4K", 3840, 2160},
+    {"8K", 7680, 4320}
+};
+
+// the values of the sixties preset, it enables every stage of the pipeline
+static const BLUfxPreset parameters = {0.0f, 1.6f, 1.5f, 0.2f, 0.0f, -0.1f, 0.0f, 0.05f, 0.0f, 0.65f};
+
+// processes a whole frame by splitting its rows evenly across the given number of threads
+static void ProcessFrame(int variant, const unsigned char *source, unsigned char *destination, int width, int height, int threadCount)
+{
+    if (threadCount == 1)
+    {
+        ProcessImage(variant, &parameters, source, destination, width, height, 0, height);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++)
+        threads.push_back(std::thread(ProcessImage, variant, &parameters, source, destination, width, height, height * i / threadCount, height * (i + 1) / threadCount));
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> threadCounts;
+    int hardwareThreads = (int) std::thread::hardware_concurrency();
+    for (int threadCount = 1; threadCount < hardwareThreads; threadCount *= 2)
+        threadCounts.push_back(threadCount);
+    threadCounts.push_back(hardwareThreads > 0 ? hardwareThreads : 1);
+
+    printf("%-6s %-8s %8s %12s\n", "Frame", "Variant", "Threads", "Mpixel/s");
+
+    for (size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+    {
+        int width = resolutions[r].width, height = resolutions[r].height;
+        size_t size = (size_t) width * height * 4;
+
+        std::vector<unsigned char> source(size), reference(size), destination(size);
+        srand(0);
+        for (size_t i = 0; i < size; i++)
+            source[i] = (unsigned char) (rand() & 0xFF);
+
+        ProcessFrame(KERNEL_VARIANT_SCALAR, &source[0], &reference[0], width, height, 1);
+
+        for (int variant = 0; variant < KERNEL_VARIANT_MAX; variant++)
+        {
+            if (!IsKernelVariantSupported(variant))
+            {
+                printf("%-6s %-8s %8s %12s\n", resolutions[r].name, GetKernelVariantName(variant), "-", "unsupported");
+                continue;
+            }
+
+            // every variant has to produce exactly the same output as the scalar reference
+            ProcessFrame(variant, &source[0], &destination[0], width, height, 1);
+            size_t mismatches = 0;
+            for (size_t i = 0; i < size; i++)
+            {
+                if (destination[i] != reference[i])
+                    mismatches++;
+            }
+
+            for (size_t t = 0; t < threadCounts.size(); t++)
+            {
+                int frames = 0;
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                double elapsedTime = 0.0;
+                do
+                {
+                    ProcessFrame(variant, &source[0], &destination[0], width, height, threadCounts[t]);
+                    frames++;
+                    elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                } while (elapsedTime < MIN_BENCHMARK_TIME);
+
+                printf("%-6s %-8s %8d %12.1f", resolutions[r].name, GetKernelVariantName(variant), threadCounts[t], (double) width * height * frames / elapsedTime / 1000000.0);
+                if (mismatches != 0)
+                    printf("  (%lu bytes differ from the scalar reference)", (unsigned long) mismatches);
+                printf("\n");
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,564 @@
+/* Copyright (C) 2018  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "blu_fx_kernel.h"
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET(instructionSet)
+#else
+#define KERNEL_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#endif
+#else
+#define KERNEL_X86 0
+#endif
+
+// define constants of the fragment-shader
+#define LUM_COEFF_RED 0.2125f
+#define LUM_COEFF_GREEN 0.7154f
+#define LUM_COEFF_BLUE 0.0721f
+#define VIGNETTE_OUTER_RADIUS 0.75f
+#define VIGNETTE_INNER_RADIUS (0.75f - 0.45f)
+
+BLUfxPreset BLUfxPresets [PRESET_MAX] =
+{
+    // PRESET_DEFAULT
+    {
+        0.0f, // brightness
+        1.0f, // contrast
+        1.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_POLAROID
+    {
+        0.05f, // brightness
+        1.1f, // contrast
+        1.4f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        -0.2f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.6f // vignette
+    },
+    // PRESET_FOGGED_UP
+    {
+        0.05f, // brightness
+        1.2f, // contrast
+        0.7f, // saturation
+        0.15f, // red scale
+        0.15f, // green scale
+        0.15f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.3f // vignette
+    },
+    // PRESET_HIGH_DYNAMIC_RANGE
+    {
+        0.0f, // brightness
+        1.15f, // contrast
+        0.9f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.6f // vignette
+    },
+    // PRESET_EDITORS_CHOICE
+    {
+        0.05f, // brightness
+        1.1f, // contrast
+        1.3f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.3f // vignette
+    },
+    // PRESET_SLIGHTLY_ENHANCED
+    {
+        0.05f, // brightness
+        1.1f, // contrast
+        1.1f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_EXTRA_GLOOMY
+    {
+        -0.15f, // brightness
+        1.3f, // contrast
+        1.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_RED_ISH
+    {
+        0.0f, // brightness
+        1.0f, // contrast
+        1.0f, // saturation
+        0.1f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_GREEN_ISH
+    {
+        0.0f, // brightness
+        1.0f, // contrast
+        1.0f, // saturation
+        0.0f, // red scale
+        0.1f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_BLUE_ISH
+    {
+        0.0f, // brightness
+        1.0f, // contrast
+        1.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.1f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_SHINY_CALIFORNIA
+    {
+        0.1f, // brightness
+        1.5f, // contrast
+        1.3f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        -0.1f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_DUSTY_DRY
+    {
+        0.0f, // brightness
+        1.3f, // contrast
+        1.3f, // saturation
+        0.2f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.0f, // green offset
+        0.0f, // blue offset
+        0.6f // vignette
+    },
+    // PRESET_GRAY_WINTER
+    {
+        0.07f, // brightness
+        1.15f, // contrast
+        1.3f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.05f, // green offset
+        0.0f, // blue offset
+        0.6f // vignette
+    },
+    // PRESET_FANCY_IMAGINATION
+    {
+        0.0f, // brightness
+        1.6f, // contrast
+        1.5f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        -0.1f, // blue scale
+        0.0f, // red offset
+        0.05f, // green offset
+        0.0f, // blue offset
+        0.6f // vignette
+    },
+    // PRESET_SIXTIES
+    {
+        0.0f, // brightness
+        1.6f, // contrast
+        1.5f, // saturation
+        0.2f, // red scale
+        0.0f, // green scale
+        -0.1f, // blue scale
+        0.0f, // red offset
+        0.05f, // green offset
+        0.0f, // blue offset
+        0.65f // vignette
+    },
+    // PRESET_COLD_WINTER
+    {
+        0.0f, // brightness
+        1.55f, // contrast
+        0.0f, // saturation
+        0.0f, // red scale
+        0.05f, // green scale
+        0.2f, // blue scale
+        0.0f, // red offset
+        0.05f, // green offset
+        0.0f, // blue offset
+        0.25f // vignette
+    },
+    // PRESET_VINTAGE_FILM
+    {
+        0.0f, // brightness
+        1.05f, // contrast
+        0.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.07f, // blue scale
+        0.07f, // red offset
+        0.03f, // green offset
+        0.0f, // blue offset
+        0.0f // vignette
+    },
+    // PRESET_COLORLESS
+    {
+        -0.03f, // brightness
+        1.3f, // contrast
+        0.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.03f, // green offset
+        0.0f, // blue offset
+        0.65f // vignette
+    },
+    // PRESET_MONOCHROME
+    {
+        -0.13f, // brightness
+        1.2f, // contrast
+        0.0f, // saturation
+        0.0f, // red scale
+        0.0f, // green scale
+        0.0f, // blue scale
+        0.0f, // red offset
+        0.03f, // green offset
+        0.0f, // blue offset
+        0.7f // vignette
+    }
+};
+
+static const char *kernelVariantNames[KERNEL_VARIANT_MAX] =
+{
+    "Scalar",
+    "SSE4.1",
+    "AVX2"
+};
+
+const char *GetKernelVariantName(int variant)
+{
+    return variant >= 0 && variant < KERNEL_VARIANT_MAX ? kernelVariantNames[variant] : "Unknown";
+}
+
+int IsKernelVariantSupported(int variant)
+{
+    if (variant == KERNEL_VARIANT_SCALAR)
+        return 1;
+
+#if KERNEL_X86
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    if (variant == KERNEL_VARIANT_SSE41)
+        return (info[2] & (1 << 19)) != 0;
+
+    if (variant == KERNEL_VARIANT_AVX2)
+    {
+        // the OS must save the AVX register state on context switches
+        if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+            return 0;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#else
+    if (variant == KERNEL_VARIANT_SSE41)
+        return __builtin_cpu_supports("sse4.1");
+
+    if (variant == KERNEL_VARIANT_AVX2)
+        return __builtin_cpu_supports("avx2");
+#endif
+#endif
+
+    return 0;
+}
+
+int GetBestKernelVariant(void)
+{
+    for (int variant = KERNEL_VARIANT_MAX - 1; variant > KERNEL_VARIANT_SCALAR; variant--)
+    {
+        if (IsKernelVariantSupported(variant))
+            return variant;
+    }
+
+    return KERNEL_VARIANT_SCALAR;
+}
+
+inline static float Clamp(float value)
+{
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+void GradeColor(const BLUfxPreset *parameters, float *color)
+{
+    const float lumCoeff[3] = {LUM_COEFF_RED, LUM_COEFF_GREEN, LUM_COEFF_BLUE};
+    const float scales[3] = {parameters->redScale, parameters->greenScale, parameters->blueScale};
+    const float offsets[3] = {parameters->redOffset, parameters->greenOffset, parameters->blueOffset};
+
+    for (int i = 0; i < 3; i++)
+        color[i] = color[i] * parameters->contrast + parameters->brightness;
+
+    float intensity = color[0] * lumCoeff[0] + color[1] * lumCoeff[1] + color[2] * lumCoeff[2];
+
+    for (int i = 0; i < 3; i++)
+    {
+        color[i] = intensity + (color[i] - intensity) * parameters->saturation;
+
+        float newColor = (color[i] - 0.5f) * 2.0f;
+        newColor = 2.0f / 3.0f * (1.0f - (newColor * newColor));
+        color[i] = Clamp(color[i] + scales[i] * newColor + offsets[i]);
+    }
+}
+
+void BuildLut(const BLUfxPreset *parameters, int size, unsigned short *data)
+{
+    unsigned short *texel = data;
+    for (int b = 0; b < size; b++)
+    {
+        for (int g = 0; g < size; g++)
+        {
+            for (int r = 0; r < size; r++)
+            {
+                float color[3] = {(float) r / (size - 1), (float) g / (size - 1), (float) b / (size - 1)};
+                GradeColor(parameters, color);
+
+                *texel++ = (unsigned short) (color[0] * 65535.0f + 0.5f);
+                *texel++ = (unsigned short) (color[1] * 65535.0f + 0.5f);
+                *texel++ = (unsigned short) (color[2] * 65535.0f + 0.5f);
+                *texel++ = 65535;
+            }
+        }
+    }
+}
+
+float GetVignetteFactor(float x, float y)
+{
+    float t = Clamp((sqrtf(x * x + y * y) - VIGNETTE_OUTER_RADIUS) / (VIGNETTE_INNER_RADIUS - VIGNETTE_OUTER_RADIUS));
+
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// processes a single pixel, x and y are the pixel position relative to the center of the image in normalized coordinates
+inline static void ProcessPixel(const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, float x, float y)
+{
+    float color[3] = {source[0] / 255.0f, source[1] / 255.0f, source[2] / 255.0f};
+    GradeColor(parameters, color);
+
+    float vig = GetVignetteFactor(x, y);
+
+    for (int i = 0; i < 3; i++)
+        destination[i] = (unsigned char) (Clamp(color[i] + (color[i] * vig - color[i]) * parameters->vignette) * 255.0f + 0.5f);
+    destination[3] = 255;
+}
+
+static void ProcessRowsScalar(const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, int width, int height, int firstRow, int lastRow)
+{
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        float y = ((float) row + 0.5f) / height - 0.5f;
+        int offset = row * width * 4;
+
+        for (int column = 0; column < width; column++)
+            ProcessPixel(parameters, source + offset + column * 4, destination + offset + column * 4, ((float) column + 0.5f) / width - 0.5f, y);
+    }
+}
+
+#if KERNEL_X86
+KERNEL_TARGET("sse4.1")
+static void ProcessRowsSse41(const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, int width, int height, int firstRow, int lastRow)
+{
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), two = _mm_set1_ps(2.0f), three = _mm_set1_ps(3.0f), twoThirds = _mm_set1_ps(2.0f / 3.0f), maxValue = _mm_set1_ps(255.0f);
+    const __m128 contrast = _mm_set1_ps(parameters->contrast), brightness = _mm_set1_ps(parameters->brightness), saturation = _mm_set1_ps(parameters->saturation), vignette = _mm_set1_ps(parameters->vignette);
+    const __m128 lumCoeff[3] = {_mm_set1_ps(LUM_COEFF_RED), _mm_set1_ps(LUM_COEFF_GREEN), _mm_set1_ps(LUM_COEFF_BLUE)};
+    const __m128 scales[3] = {_mm_set1_ps(parameters->redScale), _mm_set1_ps(parameters->greenScale), _mm_set1_ps(parameters->blueScale)};
+    const __m128 offsets[3] = {_mm_set1_ps(parameters->redOffset), _mm_set1_ps(parameters->greenOffset), _mm_set1_ps(parameters->blueOffset)};
+    const __m128 outerRadius = _mm_set1_ps(VIGNETTE_OUTER_RADIUS), radiusRange = _mm_set1_ps(VIGNETTE_INNER_RADIUS - VIGNETTE_OUTER_RADIUS);
+    const __m128 columnOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f), widthVector = _mm_set1_ps((float) width);
+    const __m128i byteMask = _mm_set1_epi32(0xFF), alpha = _mm_set1_epi32((int) 0xFF000000);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        float y = ((float) row + 0.5f) / height - 0.5f;
+        __m128 ySquared = _mm_set1_ps(y * y);
+        int offset = row * width * 4;
+
+        int column = 0;
+        for (; column + 4 <= width; column += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i *) (source + offset + column * 4));
+
+            __m128 color[3];
+            for (int i = 0; i < 3; i++)
+            {
+                color[i] = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, i * 8), byteMask)), maxValue);
+                color[i] = _mm_add_ps(_mm_mul_ps(color[i], contrast), brightness);
+            }
+
+            __m128 intensity = _mm_add_ps(_mm_add_ps(_mm_mul_ps(color[0], lumCoeff[0]), _mm_mul_ps(color[1], lumCoeff[1])), _mm_mul_ps(color[2], lumCoeff[2]));
+
+            __m128 x = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_set1_ps((float) column), columnOffsets), widthVector), half);
+            __m128 t = _mm_div_ps(_mm_sub_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), ySquared)), outerRadius), radiusRange);
+            t = _mm_min_ps(_mm_max_ps(t, zero), one);
+            __m128 vig = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t)));
+
+            __m128i result = alpha;
+            for (int i = 0; i < 3; i++)
+            {
+                color[i] = _mm_add_ps(intensity, _mm_mul_ps(_mm_sub_ps(color[i], intensity), saturation));
+
+                __m128 newColor = _mm_mul_ps(_mm_sub_ps(color[i], half), two);
+                newColor = _mm_mul_ps(twoThirds, _mm_sub_ps(one, _mm_mul_ps(newColor, newColor)));
+                newColor = _mm_add_ps(_mm_add_ps(color[i], _mm_mul_ps(scales[i], newColor)), offsets[i]);
+                color[i] = _mm_min_ps(_mm_max_ps(newColor, zero), one);
+
+                color[i] = _mm_add_ps(color[i], _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(color[i], vig), color[i]), vignette));
+                color[i] = _mm_min_ps(_mm_max_ps(color[i], zero), one);
+
+                __m128i channel = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(color[i], maxValue), half));
+                result = _mm_or_si128(result, _mm_slli_epi32(channel, i * 8));
+            }
+
+            _mm_storeu_si128((__m128i *) (destination + offset + column * 4), result);
+        }
+
+        for (; column < width; column++)
+            ProcessPixel(parameters, source + offset + column * 4, destination + offset + column * 4, ((float) column + 0.5f) / width - 0.5f, y);
+    }
+}
+
+KERNEL_TARGET("avx2")
+static void ProcessRowsAvx2(const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, int width, int height, int firstRow, int lastRow)
+{
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f), two = _mm256_set1_ps(2.0f), three = _mm256_set1_ps(3.0f), twoThirds = _mm256_set1_ps(2.0f / 3.0f), maxValue = _mm256_set1_ps(255.0f);
+    const __m256 contrast = _mm256_set1_ps(parameters->contrast), brightness = _mm256_set1_ps(parameters->brightness), saturation = _mm256_set1_ps(parameters->saturation), vignette = _mm256_set1_ps(parameters->vignette);
+    const __m256 lumCoeff[3] = {_mm256_set1_ps(LUM_COEFF_RED), _mm256_set1_ps(LUM_COEFF_GREEN), _mm256_set1_ps(LUM_COEFF_BLUE)};
+    const __m256 scales[3] = {_mm256_set1_ps(parameters->redScale), _mm256_set1_ps(parameters->greenScale), _mm256_set1_ps(parameters->blueScale)};
+    const __m256 offsets[3] = {_mm256_set1_ps(parameters->redOffset), _mm256_set1_ps(parameters->greenOffset), _mm256_set1_ps(parameters->blueOffset)};
+    const __m256 outerRadius = _mm256_set1_ps(VIGNETTE_OUTER_RADIUS), radiusRange = _mm256_set1_ps(VIGNETTE_INNER_RADIUS - VIGNETTE_OUTER_RADIUS);
+    const __m256 columnOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f), widthVector = _mm256_set1_ps((float) width);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF), alpha = _mm256_set1_epi32((int) 0xFF000000);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        float y = ((float) row + 0.5f) / height - 0.5f;
+        __m256 ySquared = _mm256_set1_ps(y * y);
+        int offset = row * width * 4;
+
+        int column = 0;
+        for (; column + 8 <= width; column += 8)
+        {
+            __m256i pixels = _mm256_loadu_si256((const __m256i *) (source + offset + column * 4));
+
+            __m256 color[3];
+            for (int i = 0; i < 3; i++)
+            {
+                color[i] = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pixels, i * 8), byteMask)), maxValue);
+                color[i] = _mm256_add_ps(_mm256_mul_ps(color[i], contrast), brightness);
+            }
+
+            __m256 intensity = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(color[0], lumCoeff[0]), _mm256_mul_ps(color[1], lumCoeff[1])), _mm256_mul_ps(color[2], lumCoeff[2]));
+
+            __m256 x = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_set1_ps((float) column), columnOffsets), widthVector), half);
+            __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), ySquared)), outerRadius), radiusRange);
+            t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+            __m256 vig = _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t)));
+
+            __m256i result = alpha;
+            for (int i = 0; i < 3; i++)
+            {
+                color[i] = _mm256_add_ps(intensity, _mm256_mul_ps(_mm256_sub_ps(color[i], intensity), saturation));
+
+                __m256 newColor = _mm256_mul_ps(_mm256_sub_ps(color[i], half), two);
+                newColor = _mm256_mul_ps(twoThirds, _mm256_sub_ps(one, _mm256_mul_ps(newColor, newColor)));
+                newColor = _mm256_add_ps(_mm256_add_ps(color[i], _mm256_mul_ps(scales[i], newColor)), offsets[i]);
+                color[i] = _mm256_min_ps(_mm256_max_ps(newColor, zero), one);
+
+                color[i] = _mm256_add_ps(color[i], _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(color[i], vig), color[i]), vignette));
+                color[i] = _mm256_min_ps(_mm256_max_ps(color[i], zero), one);
+
+                __m256i channel = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(color[i], maxValue), half));
+                result = _mm256_or_si256(result, _mm256_slli_epi32(channel, i * 8));
+            }
+
+            _mm256_storeu_si256((__m256i *) (destination + offset + column * 4), result);
+        }
+
+        for (; column < width; column++)
+            ProcessPixel(parameters, source + offset + column * 4, destination + offset + column * 4, ((float) column + 0.5f) / width - 0.5f, y);
+    }
+}
+#endif
+
+void ProcessImage(int variant, const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, int width, int height, int firstRow, int lastRow)
+{
+#if KERNEL_X86
+    if (variant == KERNEL_VARIANT_AVX2)
+        ProcessRowsAvx2(parameters, source, destination, width, height, firstRow, lastRow);
+    else if (variant == KERNEL_VARIANT_SSE41)
+        ProcessRowsSse41(parameters, source, destination, width, height, firstRow, lastRow);
+    else
+#endif
+        ProcessRowsScalar(parameters, source, destination, width, height, firstRow, lastRow);
+}
@@ -0,0 +1,117 @@
+/* Copyright (C) 2018  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// CPU implementation of the BLU-fx post-processing pipeline, it does not depend on X-Plane or OpenGL
+
+#ifndef BLU_FX_KERNEL_H
+#define BLU_FX_KERNEL_H
+
+struct BLUfxPreset_t
+{
+    // basic
+    float brightness;
+    float contrast;
+    float saturation;
+    // scale
+    float redScale;
+    float greenScale;
+    float blueScale;
+    // offset
+    float redOffset;
+    float greenOffset;
+    float blueOffset;
+    // misc
+    float vignette;
+};
+typedef BLUfxPreset_t BLUfxPreset;
+
+// indices of the fields of BLUfxPreset when it is accessed as an array of floats
+enum BLUfxParameters_t
+{
+    PARAMETER_BRIGHTNESS,
+    PARAMETER_CONTRAST,
+    PARAMETER_SATURATION,
+    PARAMETER_RED_SCALE,
+    PARAMETER_GREEN_SCALE,
+    PARAMETER_BLUE_SCALE,
+    PARAMETER_RED_OFFSET,
+    PARAMETER_GREEN_OFFSET,
+    PARAMETER_BLUE_OFFSET,
+    PARAMETER_VIGNETTE,
+    PARAMETER_MAX
+};
+
+static_assert(sizeof(BLUfxPreset) == PARAMETER_MAX * sizeof(float), "BLUfxPreset must consist of exactly PARAMETER_MAX floats");
+
+// built-in presets, their values are in BLUfxPresets
+enum BLUfxPresets_t
+{
+    PRESET_DEFAULT,
+    PRESET_POLAROID,
+    PRESET_FOGGED_UP,
+    PRESET_HIGH_DYNAMIC_RANGE,
+    PRESET_EDITORS_CHOICE,
+    PRESET_SLIGHTLY_ENHANCED,
+    PRESET_EXTRA_GLOOMY,
+    PRESET_RED_ISH,
+    PRESET_GREEN_ISH,
+    PRESET_BLUE_ISH,
+    PRESET_SHINY_CALIFORNIA,
+    PRESET_DUSTY_DRY,
+    PRESET_GRAY_WINTER,
+    PRESET_FANCY_IMAGINATION,
+    PRESET_SIXTIES,
+    PRESET_COLD_WINTER,
+    PRESET_VINTAGE_FILM,
+    PRESET_COLORLESS,
+    PRESET_MONOCHROME,
+    PRESET_MAX
+};
+
+extern BLUfxPreset BLUfxPresets[PRESET_MAX];
+
+// instruction set variants of the image kernel
+enum BLUfxKernelVariants_t
+{
+    KERNEL_VARIANT_SCALAR,
+    KERNEL_VARIANT_SSE41,
+    KERNEL_VARIANT_AVX2,
+    KERNEL_VARIANT_MAX
+};
+
+// returns a human readable name of a kernel variant
+const char *GetKernelVariantName(int variant);
+
+// checks if the CPU the code is running on supports a kernel variant
+int IsKernelVariantSupported(int variant);
+
+// returns the fastest kernel variant supported by the CPU the code is running on
+int GetBestKernelVariant(void);
+
+// applies the color-grading part of the fragment-shader to a single color, the math matches the shader exactly
+void GradeColor(const BLUfxPreset *parameters, float *color);
+
+// fills data with a size x size x size lookup table of GradeColor in RGBA16 texels, red varies fastest
+void BuildLut(const BLUfxPreset *parameters, int size, unsigned short *data);
+
+// returns the factor by which the vignette darkens a pixel at x, y relative to its center
+float GetVignetteFactor(float x, float y);
+
+// applies the fragment-shader pipeline to the rows firstRow to lastRow - 1 of an RGBA8 image, row 0 is the bottom row
+void ProcessImage(int variant, const BLUfxPreset *parameters, const unsigned char *source, unsigned char *destination, int width, int height, int firstRow, int lastRow);
+
+#endif
@@ -0,0 +1,153 @@
+/* Copyright (C) 2018  Matteo Hausner
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// standalone test of the color lookup table against the analytic color-grading, build and run it with 'make test'
+
+#include "blu_fx_kernel.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// the default lookup table size of the plugin
+#define LUT_SIZE 33
+
+// bounds of the error in 8-bit steps in cells in which GradeColor is smooth
+#define MAX_MEAN_ERROR 0.25
+#define MAX_SMOOTH_ERROR 0.5
+
+// bound of the error in cells whose corners lie on both sides of a clamp of GradeColor
+#define MAX_KINK_ERROR 7.0
+
+struct LutError_t
+{
+    double sum;
+    double smoothMaximum;
+    double kinkMaximum;
+    long long count;
+    long long kinkCount;
+};
+typedef LutError_t LutError;
+
+// returns the value of a channel of a texel of the lookup table in the range 0 to 1
+inline static float GetTexel(const unsigned short *lut, int r, int g, int b, int channel)
+{
+    return lut[((b * LUT_SIZE + g) * LUT_SIZE + r) * 4 + channel] / 65535.0f;
+}
+
+// samples the lookup table at every color of the 8-bit RGB grid the way the fragment-shader does and compares the result with GradeColor
+static void TestPreset(const BLUfxPreset *parameters, LutError *error)
+{
+    std::vector<unsigned short> lut(LUT_SIZE * LUT_SIZE * LUT_SIZE * 4);
+    BuildLut(parameters, LUT_SIZE, &lut[0]);
+
+    *error = LutError();
+
+    for (int b = 0; b < 256; b++)
+    {
+        for (int g = 0; g < 256; g++)
+        {
+            for (int r = 0; r < 256; r++)
+            {
+                float color[3] = {r / 255.0f, g / 255.0f, b / 255.0f};
+
+                // the shader maps a color onto the texel centers, so the position in texel space is color * (LUT_SIZE - 1)
+                int cell[3];
+                float weight[3];
+                for (int i = 0; i < 3; i++)
+                {
+                    float position = color[i] * (LUT_SIZE - 1);
+                    cell[i] = position >= LUT_SIZE - 1 ? LUT_SIZE - 2 : (int) position;
+                    weight[i] = position - cell[i];
+                }
+
+                float expected[3] = {color[0], color[1], color[2]};
+                GradeColor(parameters, expected);
+
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    float sampled = 0.0f;
+                    int clampedCorners = 0, lowCorners = 0, highCorners = 0;
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                        int dr = corner & 1, dg = (corner >> 1) & 1, db = (corner >> 2) & 1;
+                        float texel = GetTexel(&lut[0], cell[0] + dr, cell[1] + dg, cell[2] + db, channel);
+                        sampled += texel * (dr ? weight[0] : 1.0f - weight[0]) * (dg ? weight[1] : 1.0f - weight[1]) * (db ? weight[2] : 1.0f - weight[2]);
+
+                        if (texel <= 0.0f)
+                            lowCorners++;
+                        else if (texel >= 1.0f)
+                            highCorners++;
+                    }
+                    clampedCorners = lowCorners + highCorners;
+
+                    double difference = fabs(sampled - expected[channel]) * 255.0;
+                    error->sum += difference;
+                    error->count++;
+
+                    // a cell is smooth if none of its corners is clamped or all of them are clamped to the same bound
+                    if (clampedCorners == 0 || lowCorners == 8 || highCorners == 8)
+                    {
+                        if (difference > error->smoothMaximum)
+                            error->smoothMaximum = difference;
+                    }
+                    else
+                    {
+                        error->kinkCount++;
+                        if (difference > error->kinkMaximum)
+                            error->kinkMaximum = difference;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<LutError> errors(PRESET_MAX);
+    std::vector<std::thread> threads;
+    for (int preset = 0; preset < PRESET_MAX; preset++)
+        threads.push_back(std::thread(TestPreset, &BLUfxPresets[preset], &errors[preset]));
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    printf("LUT size %d, errors in 8-bit steps, bounds: mean %.2f, smooth max %.2f, kink max %.2f\n", LUT_SIZE, MAX_MEAN_ERROR, MAX_SMOOTH_ERROR, MAX_KINK_ERROR);
+    printf("%-6s %8s %11s %9s %8s\n", "Preset", "Mean", "Smooth max", "Kink max", "Kink %");
+
+    int failures = 0;
+    for (int preset = 0; preset < PRESET_MAX; preset++)
+    {
+        const LutError *error = &errors[preset];
+        double mean = error->sum / error->count;
+        int failed = mean > MAX_MEAN_ERROR || error->smoothMaximum > MAX_SMOOTH_ERROR || error->kinkMaximum > MAX_KINK_ERROR;
+
+        printf("%-6d %8.4f %11.4f %9.4f %8.3f%s\n", preset, mean, error->smoothMaximum, error->kinkMaximum, 100.0 * error->kinkCount / error->count, failed ? "  FAILED" : "");
+        failures += failed;
+    }
+
+    if (failures != 0)
+    {
+        printf("%d of %d presets exceed the error bounds\n", failures, PRESET_MAX);
+        return 1;
+    }
+
+    printf("All presets are within the error bounds\n");
+
+    return 0;
+}